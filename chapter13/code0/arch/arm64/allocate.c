@@ -71,6 +71,8 @@ static void alloc_dram_pages(struct address_region *addrreg,
         p.allocated = allocated_for_page_dir;
         p.reserved = allocated_for_page_dir;
         p.valid = 1;
+        p.movable = 0;
+        p.migratetype = MIGRATE_UNMOVABLE;
         p.current_order = end_shift - PAGE_SHIFT;
         p.original_order = end_shift - PAGE_SHIFT;
         p.pfn = startframe;
@@ -93,6 +95,37 @@ static void alloc_dram_pages(struct address_region *addrreg,
     }
 }
 
+static void alloc_contig_region(struct address_region *addrreg,
+    struct contigregion *contig, unsigned long firstfree)
+{
+    unsigned long start, end = addrreg->start + addrreg->size;
+    if(addrreg->size <= CONTIG_REGION_SIZE || (end - CONTIG_REGION_SIZE) < firstfree) {
+        return;
+    }
+    start = end - CONTIG_REGION_SIZE;
+    while(start < end) {
+        struct page p;
+        unsigned long frame = start >> PAGE_SHIFT;
+        p.allocated = 1;
+        p.reserved = 1;
+        p.valid = 1;
+        p.movable = 0;
+        p.migratetype = MIGRATE_UNMOVABLE;
+        p.current_order = 0;
+        p.original_order = 0;
+        p.pfn = frame;
+        p.pagelist.next = 0;
+        p.pagelist.prev = 0;
+        p.refcount = 0;
+        GLOBAL_MEMMAP[frame] = p;
+        start += PAGE_SIZE;
+    }
+    contig->startpfn = (end - CONTIG_REGION_SIZE) >> PAGE_SHIFT;
+    contig->numpages = CONTIG_REGION_PAGES;
+    contig->freepages = CONTIG_REGION_PAGES;
+    addrreg->size -= CONTIG_REGION_SIZE;
+}
+
 static void alloc_kernel_pages(struct address_region *addrreg, struct list *freelists)
 {
     unsigned long start = addrreg->start;
@@ -107,6 +140,8 @@ static void alloc_kernel_pages(struct address_region *addrreg, struct list *free
         p.allocated = 1;
         p.reserved = 1;
         p.valid = 1;
+        p.movable = 0;
+        p.migratetype = MIGRATE_UNMOVABLE;
         p.current_order = 9;
         p.original_order = 9;
         p.pfn = startframe;
@@ -141,6 +176,8 @@ static void alloc_overwrite_pages(struct address_region *addrreg, struct list *f
         p.allocated = 0;
         p.reserved = 0;
         p.valid = 1;
+        p.movable = 0;
+        p.migratetype = MIGRATE_UNMOVABLE;
         p.current_order = OVERWRITE_FREEBLOCK_SHIFT;
         p.original_order = OVERWRITE_FREEBLOCK_SHIFT;
         p.pfn = startframe;
@@ -175,6 +212,8 @@ static void alloc_unused_baby_boot_pages(struct address_region *addrreg,
         p.allocated = 1;
         p.reserved = 1;
         p. valid = 1;
+        p.movable = 0;
+        p.migratetype = MIGRATE_UNMOVABLE;
         p.current_order = 0;
         p.original_order = 0;
         p.pfn = frame;
@@ -195,7 +234,8 @@ static void alloc_unused_baby_boot_pages(struct address_region *addrreg,
     }
 }
 
-void arch_populate_allocate_structures(struct list *freelists)
+unsigned long arch_populate_allocate_structures(struct list *freelists,
+    struct contigregion *contig)
 {
     unsigned long firstfree, physstart, numpages;
     struct address_region addrreg;
@@ -220,11 +260,15 @@ void arch_populate_allocate_structures(struct list *freelists)
                     alloc_unused_baby_boot_pages(&addrreg, freelists);
                     break;
                 default:
+                    if(!contig->numpages) {
+                        alloc_contig_region(&addrreg, contig, firstfree);
+                    }
                     alloc_dram_pages(&addrreg, freelists, firstfree);
                     break;
             }
         }
     }
+    return numpages;
 }
 
 static void initialize_baby_boot_allocator(unsigned long start, unsigned long end)
@@ -13,24 +13,31 @@
  */
 
 #include "cake/log.h"
+#include "arch/smp.h"
 #include "board/bare-metal.h"
 
+#define IRQ_RESCHEDULE          (0x0)
 #define IRQ_TIMER3              (0x3)
 #define IRQ_AUX                 (0x1D)
 #define IRQ_MASK(irq)           (1 << (irq))
 
+#define IRQ_CNTPNS_SOURCE       (1)
 #define IRQ_MAILBOX3_SOURCE     (7)
 #define IRQ_GPU_SOURCE          (8)
 #define IRQ_SOURCE(source)      (1 << (source))
 
-extern void __irq_broadcast(unsigned int irq);
+extern void __irq_enable_core_timer();
 extern void __irq_enable_id(unsigned int irq);
 extern void __irq_enable_mailbox3();
 extern unsigned int __irq_mailbox();
 extern void __irq_mailbox_clear(unsigned long irq);
+extern void __irq_mailbox_send(unsigned long irq, unsigned long cpumask);
 extern unsigned int __irq_read();
 extern unsigned int __irq_source();
+extern void generic_timer_interrupt();
+extern void reschedule_interrupt();
 extern void rpi3_miniuart_interrupt();
+extern unsigned long tick_broadcast_cpumask();
 extern void timer_interrupt();
 extern void timer_tick();
 
@@ -40,10 +47,17 @@ void handle_irq()
     do {
         source = __irq_source();
         if(source) {
-            if(source & IRQ_SOURCE(IRQ_GPU_SOURCE)) {
+            if(source & IRQ_SOURCE(IRQ_CNTPNS_SOURCE)) {
+                generic_timer_interrupt();
+                if(!SMP_ID()) {
+                    __irq_mailbox_send(IRQ_TIMER3, tick_broadcast_cpumask());
+                }
+                timer_tick();
+            }
+            else if(source & IRQ_SOURCE(IRQ_GPU_SOURCE)) {
                 irq = __irq_read();
                 if(irq & IRQ_MASK(IRQ_TIMER3)) {
-                    __irq_broadcast(IRQ_TIMER3);
+                    __irq_mailbox_send(IRQ_TIMER3, tick_broadcast_cpumask());
                     timer_interrupt();
                     timer_tick();
                 }
@@ -56,7 +70,11 @@ void handle_irq()
             }
             else if(source & IRQ_SOURCE(IRQ_MAILBOX3_SOURCE)) {
                 irq = __irq_mailbox();
-                if(irq & IRQ_MASK(IRQ_TIMER3)) {
+                if(irq & IRQ_MASK(IRQ_RESCHEDULE)) {
+                    __irq_mailbox_clear(IRQ_RESCHEDULE);
+                    reschedule_interrupt();
+                }
+                else if(irq & IRQ_MASK(IRQ_TIMER3)) {
                     __irq_mailbox_clear(IRQ_TIMER3);
                     timer_tick();
                 }
@@ -75,9 +93,23 @@ void handle_irq()
 }
 
 
-void irq_init()
+void irq_enable_generic_timer()
+{
+    __irq_enable_core_timer();
+}
+
+void irq_enable_system_timer()
 {
     __irq_enable_id(IRQ_TIMER3);
+}
+
+void irq_send_reschedule(unsigned long cpu)
+{
+    __irq_mailbox_send(IRQ_RESCHEDULE, 1UL << cpu);
+}
+
+void irq_init()
+{
     __irq_enable_id(IRQ_AUX);
     __irq_enable_mailbox3();
 }
@@ -12,23 +12,53 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#define INTERRUPT_INTERVAL  (100000)
+#include "config/config.h"
+
+#define SYSTEM_TIMER_HZ     (1000000)
+#define INTERRUPT_INTERVAL  ((SYSTEM_TIMER_HZ) / (TIMER_HZ))
 
 extern unsigned int __timer_clock_low();
 extern void __timer_control_reset();
 extern void __timer_set_compare(unsigned int compare);
+extern int generic_timer_init();
+extern int generic_timer_start();
+extern void irq_enable_generic_timer();
+extern void irq_enable_system_timer();
+extern void tick_broadcast_enable(unsigned long cpu);
+
+static void system_timer_arm();
 
 static unsigned int current;
 
-void timer_init()
+static void system_timer_arm()
 {
     current = __timer_clock_low();
     current += INTERRUPT_INTERVAL;
     __timer_set_compare(current);
 }
 
+void timer_init()
+{
+    if(generic_timer_init()) {
+        irq_enable_generic_timer();
+        return;
+    }
+    for(unsigned long cpu = 1; cpu < NUM_CPUS; cpu++) {
+        tick_broadcast_enable(cpu);
+    }
+    system_timer_arm();
+    irq_enable_system_timer();
+}
+
+void timer_init_cpu()
+{
+    if(generic_timer_start()) {
+        irq_enable_generic_timer();
+    }
+}
+
 void timer_interrupt()
 {
-    timer_init();
+    system_timer_arm();
     __timer_control_reset();
 }
@@ -13,10 +13,13 @@
  */
 
 #include "cake/log.h"
+#include "arch/smp.h"
 #include "board/bare-metal.h"
 #include "board/gic.h"
 
 #define SPID_SGI_TIMER      (0x03)
+#define SPID_SGI_RESCHEDULE (0x04)
+#define SPID_PPI_TIMER      (0x1E)
 #define SPID_TIMER3         (0x63)
 #define SPID_AUX            (0x7D)
 
@@ -30,11 +33,14 @@
 #define IRQ_CPUID_VALUE(irq)    ((irq & IRQ_CPUID_MASK) >> IRQ_CPUID_SHIFT)
 
 extern unsigned int __irq_acknowledge();
-extern void __irq_broadcast_sgi(unsigned long sgi);
 extern void __irq_enable_spid(unsigned long spid);
 extern void __irq_end(unsigned int irq);
+extern void __irq_send_sgi(unsigned long sgi, unsigned long cpumask);
 extern void __irq_target_cpumask(unsigned long spid, unsigned long mask);
+extern void generic_timer_interrupt();
+extern void reschedule_interrupt();
 extern void rpi4_miniuart_interrupt();
+extern unsigned long tick_broadcast_cpumask();
 extern void timer_interrupt();
 extern void timer_tick();
 
@@ -55,8 +61,18 @@ void handle_irq()
                 case SPID_SGI_TIMER:
                     timer_tick();
                     break;
+                case SPID_SGI_RESCHEDULE:
+                    reschedule_interrupt();
+                    break;
+                case SPID_PPI_TIMER:
+                    generic_timer_interrupt();
+                    if(!SMP_ID()) {
+                        __irq_send_sgi(SPID_SGI_TIMER, tick_broadcast_cpumask());
+                    }
+                    timer_tick();
+                    break;
                 case SPID_TIMER3:
-                    __irq_broadcast_sgi(SPID_SGI_TIMER);
+                    __irq_send_sgi(SPID_SGI_TIMER, tick_broadcast_cpumask());
                     timer_interrupt();
                     timer_tick();
                     break;
@@ -76,10 +92,24 @@ void handle_irq()
 
 static void init_irq_registers()
 {
-    __irq_enable_spid(SPID_TIMER3);
     __irq_enable_spid(SPID_AUX);
 }
 
+void irq_enable_generic_timer()
+{
+    __irq_enable_spid(SPID_PPI_TIMER);
+}
+
+void irq_enable_system_timer()
+{
+    __irq_enable_spid(SPID_TIMER3);
+}
+
+void irq_send_reschedule(unsigned long cpu)
+{
+    __irq_send_sgi(SPID_SGI_RESCHEDULE, 1UL << cpu);
+}
+
 void irq_init()
 {
     init_irq_registers();
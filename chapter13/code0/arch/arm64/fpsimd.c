@@ -0,0 +1,88 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config/config.h"
+#include "cake/process.h"
+#include "cake/schedule.h"
+#include "arch/fpsimd.h"
+#include "arch/process.h"
+#include "arch/schedule.h"
+#include "arch/smp.h"
+
+extern void __fpsimd_disable();
+extern void __fpsimd_enable();
+extern void __fpsimd_load(struct fpsimd_state *state);
+extern void __fpsimd_save(struct fpsimd_state *state);
+extern void memset(void *dest, int c, unsigned long count);
+
+static struct process *fpsimd_owner[NUM_CPUS];
+
+void fpsimd_exec()
+{
+    struct process *current = CURRENT;
+    PREEMPT_DISABLE();
+    fpsimd_flush_current();
+    memset(&(current->context.fpsimd), 0, sizeof(current->context.fpsimd));
+    current->context.fpsimd_flags = 0;
+    PREEMPT_ENABLE();
+}
+
+void fpsimd_flush_current()
+{
+    struct process *current = CURRENT;
+    PREEMPT_DISABLE();
+    if(current->context.fpsimd_flags & FPSIMD_LIVE) {
+        __fpsimd_disable();
+        current->context.fpsimd_flags &= ~FPSIMD_LIVE;
+    }
+    current->context.fpsimd_cpu = NUM_CPUS;
+    PREEMPT_ENABLE();
+}
+
+void fpsimd_save_current()
+{
+    struct process *current = CURRENT;
+    PREEMPT_DISABLE();
+    if(current->context.fpsimd_flags & FPSIMD_LIVE) {
+        __fpsimd_save(&(current->context.fpsimd));
+    }
+    PREEMPT_ENABLE();
+}
+
+void fpsimd_switch(struct process *prev)
+{
+    unsigned long cpu;
+    if(!(prev->context.fpsimd_flags & FPSIMD_LIVE)) {
+        return;
+    }
+    cpu = SMP_ID();
+    __fpsimd_save(&(prev->context.fpsimd));
+    __fpsimd_disable();
+    prev->context.fpsimd_flags &= ~FPSIMD_LIVE;
+    prev->context.fpsimd_cpu = cpu;
+    fpsimd_owner[cpu] = prev;
+}
+
+void fpsimd_trap()
+{
+    unsigned long cpu = SMP_ID();
+    struct process *current = CURRENT;
+    __fpsimd_enable();
+    if(fpsimd_owner[cpu] != current || current->context.fpsimd_cpu != cpu) {
+        __fpsimd_load(&(current->context.fpsimd));
+        fpsimd_owner[cpu] = current;
+        current->context.fpsimd_cpu = cpu;
+    }
+    current->context.fpsimd_flags |= (FPSIMD_LIVE | FPSIMD_USED);
+}
@@ -15,6 +15,7 @@
 #ifndef _ARCH_ABORT_H
 #define _ARCH_ABORT_H
 
+#define ESR_ELx_EC_FP_ASIMD     (0x07)
 #define ESR_ELx_EC_SVC64        (0x15)
 #define ESR_ELx_EC_DABT_LOW     (0x24)
 #define ESR_ELx_EC_IABT_LOW     (0x20)
@@ -24,19 +24,187 @@
 #define ATOMIC_LONG_INC(var)            ATOMIC_LONG_ADD(var, 1)
 #define ATOMIC_LONG_OR                  __atomic64_or
 #define ATOMIC_LONG_SUB_RETURN          __atomic64_sub_return
+#define CMPXCHG_ACQUIRE                 __cmpxchg_acquire
 #define CMPXCHG_RELAXED                 __cmpxchg_relaxed
 #define XCHG_RELAXED                    __xchg_relaxed
 
-void __atomic64_add(volatile unsigned long *initial, unsigned long count);
-unsigned long __atomic64_add_return(volatile unsigned long *initial, unsigned long count);
-unsigned long __atomic64_add_return_relaxed(volatile unsigned long *initial, 
-    unsigned long count);
-void __atomic64_andnot(volatile unsigned long *bitmap, unsigned long bit);
-int __atomic64_fetch_andnot(volatile unsigned long *bitmap, unsigned long bit);
-int __atomic64_fetch_or(volatile unsigned long *bitmap, unsigned long bit);
-void __atomic64_or(volatile unsigned long *bitmap, unsigned long bit);
-unsigned long __atomic64_sub_return(volatile unsigned long *initial, unsigned long count);
-unsigned long __cmpxchg_relaxed(volatile void *ptr, unsigned long cmp, unsigned long xchg);
-unsigned long __xchg_relaxed(volatile void *ptr, unsigned long xchg);
+static inline void __atomic64_add(volatile unsigned long *initial, unsigned long count)
+{
+    unsigned long result;
+    unsigned int status;
+    asm volatile(
+        "   prfm    pstl1strm, %2\n"
+        "1: ldxr    %0, %2\n"
+        "   add     %0, %0, %3\n"
+        "   stxr    %w1, %0, %2\n"
+        "   cbnz    %w1, 1b"
+        : "=&r" (result), "=&r" (status), "+Q" (*initial)
+        : "r" (count));
+}
+
+static inline unsigned long __atomic64_add_return(volatile unsigned long *initial,
+    unsigned long count)
+{
+    unsigned long result;
+    unsigned int status;
+    asm volatile(
+        "   prfm    pstl1strm, %2\n"
+        "1: ldxr    %0, %2\n"
+        "   add     %0, %0, %3\n"
+        "   stlxr   %w1, %0, %2\n"
+        "   cbnz    %w1, 1b\n"
+        "   dmb     ish"
+        : "=&r" (result), "=&r" (status), "+Q" (*initial)
+        : "r" (count)
+        : "memory");
+    return result;
+}
+
+static inline unsigned long __atomic64_add_return_relaxed(volatile unsigned long *initial,
+    unsigned long count)
+{
+    unsigned long result;
+    unsigned int status;
+    asm volatile(
+        "   prfm    pstl1strm, %2\n"
+        "1: ldxr    %0, %2\n"
+        "   add     %0, %0, %3\n"
+        "   stxr    %w1, %0, %2\n"
+        "   cbnz    %w1, 1b"
+        : "=&r" (result), "=&r" (status), "+Q" (*initial)
+        : "r" (count));
+    return result;
+}
+
+static inline void __atomic64_andnot(volatile unsigned long *bitmap, unsigned long bit)
+{
+    unsigned long result;
+    unsigned int status;
+    asm volatile(
+        "   prfm    pstl1strm, %2\n"
+        "1: ldxr    %0, %2\n"
+        "   bic     %0, %0, %3\n"
+        "   stxr    %w1, %0, %2\n"
+        "   cbnz    %w1, 1b"
+        : "=&r" (result), "=&r" (status), "+Q" (*bitmap)
+        : "r" (bit));
+}
+
+static inline unsigned long __atomic64_fetch_andnot(volatile unsigned long *bitmap,
+    unsigned long bit)
+{
+    unsigned long old, result;
+    unsigned int status;
+    asm volatile(
+        "   prfm    pstl1strm, %3\n"
+        "1: ldxr    %0, %3\n"
+        "   bic     %1, %0, %4\n"
+        "   stlxr   %w2, %1, %3\n"
+        "   cbnz    %w2, 1b\n"
+        "   dmb     ish"
+        : "=&r" (old), "=&r" (result), "=&r" (status), "+Q" (*bitmap)
+        : "r" (bit)
+        : "memory");
+    return old;
+}
+
+static inline unsigned long __atomic64_fetch_or(volatile unsigned long *bitmap,
+    unsigned long bit)
+{
+    unsigned long old, result;
+    unsigned int status;
+    asm volatile(
+        "   prfm    pstl1strm, %3\n"
+        "1: ldxr    %0, %3\n"
+        "   orr     %1, %0, %4\n"
+        "   stlxr   %w2, %1, %3\n"
+        "   cbnz    %w2, 1b\n"
+        "   dmb     ish"
+        : "=&r" (old), "=&r" (result), "=&r" (status), "+Q" (*bitmap)
+        : "r" (bit)
+        : "memory");
+    return old;
+}
+
+static inline void __atomic64_or(volatile unsigned long *bitmap, unsigned long bit)
+{
+    unsigned long result;
+    unsigned int status;
+    asm volatile(
+        "   prfm    pstl1strm, %2\n"
+        "1: ldxr    %0, %2\n"
+        "   orr     %0, %0, %3\n"
+        "   stxr    %w1, %0, %2\n"
+        "   cbnz    %w1, 1b"
+        : "=&r" (result), "=&r" (status), "+Q" (*bitmap)
+        : "r" (bit));
+}
+
+static inline unsigned long __atomic64_sub_return(volatile unsigned long *initial,
+    unsigned long count)
+{
+    unsigned long result;
+    unsigned int status;
+    asm volatile(
+        "   prfm    pstl1strm, %2\n"
+        "1: ldxr    %0, %2\n"
+        "   sub     %0, %0, %3\n"
+        "   stlxr   %w1, %0, %2\n"
+        "   cbnz    %w1, 1b\n"
+        "   dmb     ish"
+        : "=&r" (result), "=&r" (status), "+Q" (*initial)
+        : "r" (count)
+        : "memory");
+    return result;
+}
+
+static inline unsigned long __cmpxchg_acquire(volatile void *ptr, unsigned long cmp,
+    unsigned long xchg)
+{
+    unsigned long old, status;
+    asm volatile(
+        "   prfm    pstl1strm, %2\n"
+        "1: ldaxr   %0, %2\n"
+        "   eor     %1, %0, %3\n"
+        "   cbnz    %1, 2f\n"
+        "   stxr    %w1, %4, %2\n"
+        "   cbnz    %w1, 1b\n"
+        "2:"
+        : "=&r" (old), "=&r" (status), "+Q" (*(volatile unsigned long *) ptr)
+        : "r" (cmp), "r" (xchg)
+        : "memory");
+    return old;
+}
+
+static inline unsigned long __cmpxchg_relaxed(volatile void *ptr, unsigned long cmp,
+    unsigned long xchg)
+{
+    unsigned long old, status;
+    asm volatile(
+        "   prfm    pstl1strm, %2\n"
+        "1: ldxr    %0, %2\n"
+        "   eor     %1, %0, %3\n"
+        "   cbnz    %1, 2f\n"
+        "   stxr    %w1, %4, %2\n"
+        "   cbnz    %w1, 1b\n"
+        "2:"
+        : "=&r" (old), "=&r" (status), "+Q" (*(volatile unsigned long *) ptr)
+        : "r" (cmp), "r" (xchg));
+    return old;
+}
+
+static inline unsigned long __xchg_relaxed(volatile void *ptr, unsigned long xchg)
+{
+    unsigned long old;
+    unsigned int status;
+    asm volatile(
+        "   prfm    pstl1strm, %2\n"
+        "1: ldxr    %0, %2\n"
+        "   stxr    %w1, %3, %2\n"
+        "   cbnz    %w1, 1b"
+        : "=&r" (old), "=&r" (status), "+Q" (*(volatile unsigned long *) ptr)
+        : "r" (xchg));
+    return old;
+}
 
 #endif
@@ -40,6 +40,8 @@
 #define CACHE_C_FLAG            BIT_SET(2)
 #define CACHE_I_FLAG            BIT_SET(12)
 
+#define CNTKCTL_EL1_EL0VCTEN    BIT_SET(1)
+
 #define MPIDR_HWID_MASK_LITE    (0xFFFFFF)
 #define ALL_CPUS_MASK           ((NUM_CPUS) - 1)
 #define CPU_IN_PEN              (0b00)
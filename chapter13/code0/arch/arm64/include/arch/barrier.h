@@ -37,8 +37,17 @@
 #define LOAD_ACQUIRE(ptr)           __load_acquire(ptr)
 #define STORE_RELEASE(ptr, val)     __store_release(ptr, val)
 
-unsigned long __load_acquire(void *src);
-void __store_release(void *dest, unsigned long val);
+static inline unsigned long __load_acquire(void *src)
+{
+    unsigned long val;
+    asm volatile("ldar %0, %1" : "=r" (val) : "Q" (*(volatile unsigned long *) src) : "memory");
+    return val;
+}
+
+static inline void __store_release(void *dest, unsigned long val)
+{
+    asm volatile("stlr %1, %0" : "=Q" (*(volatile unsigned long *) dest) : "r" (val) : "memory");
+}
 
 #endif
 
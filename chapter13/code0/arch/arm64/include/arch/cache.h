@@ -15,7 +15,13 @@
 #ifndef _ARCH_CACHE_H
 #define _ARCH_CACHE_H
 
+#define L1_CACHE_SHIFT  (6)
+#define L1_CACHE_BYTES  ((1) << (L1_CACHE_SHIFT))
+
+#define ZERO_DCACHE_RANGE   __zero_dcache_range
+
 void __clean_and_inval_dcache_range(volatile void *va, unsigned long size);
 void __tlbi_vmalle1();
+void __zero_dcache_range(void *va, unsigned long size);
 
 #endif
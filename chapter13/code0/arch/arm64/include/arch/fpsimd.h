@@ -0,0 +1,37 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _ARCH_FPSIMD_H
+#define _ARCH_FPSIMD_H
+
+#include "cake/types.h"
+
+#define FPSIMD_LIVE     (0b01)
+#define FPSIMD_USED     (0b10)
+
+struct process;
+
+struct fpsimd_state {
+    u64 vregs[64] __attribute__((__aligned__(16)));
+    u32 fpsr;
+    u32 fpcr;
+};
+
+void fpsimd_exec();
+void fpsimd_flush_current();
+void fpsimd_save_current();
+void fpsimd_switch(struct process *prev);
+void fpsimd_trap();
+
+#endif
@@ -16,10 +16,12 @@
 #define _ARCH_IRQ_H
 
 #define IRQ_DISABLE         __irq_disable
+#define IRQ_DISABLED        __irq_disabled
 #define IRQ_ENABLE          __irq_enable
 #define WAIT_FOR_INTERRUPT  __wait_for_interrupt
 
 extern void __irq_disable();
+extern unsigned long __irq_disabled();
 extern void __irq_enable();
 extern void __wait_for_interrupt();
 
@@ -15,20 +15,228 @@
 #ifndef _ARCH_LOCK_H
 #define _ARCH_LOCK_H
 
+#include "config/config.h"
 #include "cake/lock.h"
+#include "cake/lockstat.h"
 #include "cake/schedule.h"
+#include "arch/atomic.h"
+#include "arch/timer.h"
 
+#if QUEUED_SPINLOCK
+#define __spin_lock             __queued_spin_lock
+#define __spin_trylock          __queued_spin_trylock
+#define __spin_unlock           __queued_spin_unlock
+#else
+#define __spin_lock             __ticket_spin_lock
+#define __spin_trylock          __ticket_spin_trylock
+#define __spin_unlock           __ticket_spin_unlock
+#endif
+
+#define READ_LOCK               read_lock
+#define READ_UNLOCK             read_unlock
+#if LOCKSTAT
+#define SPIN_LOCK(lock)                     spin_lock_stat(lock, LOCKSTAT_SITE(lock))
+#define SPIN_LOCK_IRQSAVE(lock)             spin_lock_irqsave_stat(lock, LOCKSTAT_SITE(lock))
+#define SPIN_TRYLOCK(lock)                  spin_trylock_stat(lock, LOCKSTAT_SITE(lock))
+#define SPIN_UNLOCK(lock)                   spin_unlock_stat(lock)
+#define SPIN_UNLOCK_IRQRESTORE(lock, flags) spin_unlock_irqrestore_stat(lock, flags)
+#else
 #define SPIN_LOCK               spin_lock
-#define SPIN_LOCK_BOOT          __spin_lock
 #define SPIN_LOCK_IRQSAVE       spin_lock_irqsave
+#define SPIN_TRYLOCK            spin_trylock
 #define SPIN_UNLOCK             spin_unlock
-#define SPIN_UNLOCK_BOOT        __spin_unlock
 #define SPIN_UNLOCK_IRQRESTORE  spin_unlock_irqrestore
+#endif
+#define SPIN_TRYLOCK_IRQSAVE    spin_trylock_irqsave
+#define SPIN_LOCK_BOOT          __spin_lock
+#define SPIN_UNLOCK_BOOT        __spin_unlock
+#define WRITE_LOCK              write_lock
+#define WRITE_LOCK_IRQSAVE      write_lock_irqsave
+#define WRITE_TRYLOCK_IRQSAVE   write_trylock_irqsave
+#define WRITE_UNLOCK            write_unlock
+#define WRITE_UNLOCK_IRQRESTORE write_unlock_irqrestore
+
+#define QSPIN_LOCKED            (1)
+#define RWLOCK_WRITER           (0x80000000)
+#define TICKET_SHIFT            (32)
+#define TICKET_VALUE            (1UL << TICKET_SHIFT)
+
+void queued_spin_lock_slowpath(struct spinlock *lock);
+
+static inline void __irq_restore(unsigned long flags)
+{
+    asm volatile("msr daif, %0" : : "r" (flags) : "memory");
+}
+
+static inline unsigned long __irq_save()
+{
+    unsigned long flags;
+    asm volatile("mrs %0, daif\n\tmsr daifset, #2" : "=r" (flags) : : "memory");
+    return flags;
+}
+
+static inline void __queued_spin_lock(struct spinlock *lock)
+{
+    if(CMPXCHG_ACQUIRE(lock, 0, QSPIN_LOCKED)) {
+        queued_spin_lock_slowpath(lock);
+    }
+}
+
+static inline int __queued_spin_trylock(struct spinlock *lock)
+{
+    return !CMPXCHG_ACQUIRE(lock, 0, QSPIN_LOCKED);
+}
+
+static inline void __queued_spin_unlock(struct spinlock *lock)
+{
+    asm volatile("stlr wzr, %0" : "=Q" (lock->owner) : : "memory");
+}
+
+static inline void __read_lock(struct rwlock *lock)
+{
+    unsigned int count, status;
+    asm volatile(
+        "   sevl\n"
+        "1: wfe\n"
+        "2: ldaxr   %w0, %2\n"
+        "   add     %w0, %w0, #1\n"
+        "   tbnz    %w0, #31, 1b\n"
+        "   stxr    %w1, %w0, %2\n"
+        "   cbnz    %w1, 2b"
+        : "=&r" (count), "=&r" (status), "+Q" (lock->count)
+        :
+        : "memory");
+}
+
+static inline void __read_unlock(struct rwlock *lock)
+{
+    unsigned int count, status;
+    asm volatile(
+        "1: ldxr    %w0, %2\n"
+        "   sub     %w0, %w0, #1\n"
+        "   stlxr   %w1, %w0, %2\n"
+        "   cbnz    %w1, 1b"
+        : "=&r" (count), "=&r" (status), "+Q" (lock->count)
+        :
+        : "memory");
+}
+
+static inline void __ticket_spin_lock(struct spinlock *lock)
+{
+    unsigned long old, next;
+    unsigned int status;
+    asm volatile(
+        "   prfm    pstl1strm, %3\n"
+        "1: ldaxr   %0, %3\n"
+        "   add     %1, %0, %4\n"
+        "   stxr    %w2, %1, %3\n"
+        "   cbnz    %w2, 1b\n"
+        "   eor     %1, %0, %0, ror #32\n"
+        "   cbz     %1, 3f\n"
+        "   sevl\n"
+        "2: wfe\n"
+        "   ldaxr   %w2, %3\n"
+        "   eor     %1, %2, %0, lsr #32\n"
+        "   cbnz    %1, 2b\n"
+        "3:"
+        : "=&r" (old), "=&r" (next), "=&r" (status), "+Q" (*(unsigned long *) lock)
+        : "r" (TICKET_VALUE)
+        : "memory");
+}
+
+static inline int __ticket_spin_trylock(struct spinlock *lock)
+{
+    unsigned long old, next;
+    unsigned int status;
+    asm volatile(
+        "   prfm    pstl1strm, %3\n"
+        "1: ldaxr   %0, %3\n"
+        "   eor     %1, %0, %0, ror #32\n"
+        "   cbnz    %1, 2f\n"
+        "   add     %1, %0, %4\n"
+        "   stxr    %w2, %1, %3\n"
+        "   cbnz    %w2, 1b\n"
+        "   mov     %w2, #1\n"
+        "   b       3f\n"
+        "2: clrex\n"
+        "   mov     %w2, #0\n"
+        "3:"
+        : "=&r" (old), "=&r" (next), "=&r" (status), "+Q" (*(unsigned long *) lock)
+        : "r" (TICKET_VALUE)
+        : "memory");
+    return status;
+}
+
+static inline void __ticket_spin_unlock(struct spinlock *lock)
+{
+    unsigned int owner;
+    asm volatile(
+        "   ldr     %w0, %1\n"
+        "   add     %w0, %w0, #1\n"
+        "   stlr    %w0, %1"
+        : "=&r" (owner), "+Q" (lock->owner)
+        :
+        : "memory");
+}
+
+static inline void __spin_lock_stat(struct spinlock *lock, struct lockstat *site)
+{
+    unsigned long start;
+    if(__spin_trylock(lock)) {
+        lockstat_acquire(lock, site, 0, 0);
+        return;
+    }
+    start = TIMER_COUNT();
+    __spin_lock(lock);
+    lockstat_acquire(lock, site, 1, TIMER_COUNT() - start);
+}
+
+static inline void __write_lock(struct rwlock *lock)
+{
+    unsigned int count;
+    asm volatile(
+        "   sevl\n"
+        "1: wfe\n"
+        "2: ldaxr   %w0, %1\n"
+        "   cbnz    %w0, 1b\n"
+        "   stxr    %w0, %w2, %1\n"
+        "   cbnz    %w0, 2b"
+        : "=&r" (count), "+Q" (lock->count)
+        : "r" (RWLOCK_WRITER)
+        : "memory");
+}
+
+static inline int __write_trylock(struct rwlock *lock)
+{
+    unsigned int count;
+    asm volatile(
+        "1: ldaxr   %w0, %1\n"
+        "   cbnz    %w0, 2f\n"
+        "   stxr    %w0, %w2, %1\n"
+        "   cbnz    %w0, 1b\n"
+        "2:"
+        : "=&r" (count), "+Q" (lock->count)
+        : "r" (RWLOCK_WRITER)
+        : "memory");
+    return !count;
+}
+
+static inline void __write_unlock(struct rwlock *lock)
+{
+    asm volatile("stlr wzr, %0" : "=Q" (lock->count) : : "memory");
+}
+
+static inline void read_lock(struct rwlock *lock)
+{
+    PREEMPT_DISABLE();
+    __read_lock(lock);
+}
 
-void __irq_restore(unsigned long flags);
-unsigned long __irq_save();
-void __spin_lock(struct spinlock *lock);
-void __spin_unlock(struct spinlock *lock);
+static inline void read_unlock(struct rwlock *lock)
+{
+    __read_unlock(lock);
+    PREEMPT_ENABLE();
+}
 
 static inline void spin_lock(struct spinlock *lock)
 {
@@ -45,6 +253,53 @@ static inline unsigned long spin_lock_irqsave(struct spinlock *lock)
     return flags;
 }
 
+static inline unsigned long spin_lock_irqsave_stat(struct spinlock *lock,
+    struct lockstat *site)
+{
+    unsigned long flags;
+    PREEMPT_DISABLE();
+    flags = __irq_save();
+    __spin_lock_stat(lock, site);
+    return flags;
+}
+
+static inline void spin_lock_stat(struct spinlock *lock, struct lockstat *site)
+{
+    PREEMPT_DISABLE();
+    __spin_lock_stat(lock, site);
+}
+
+static inline int spin_trylock(struct spinlock *lock)
+{
+    PREEMPT_DISABLE();
+    if(__spin_trylock(lock)) {
+        return 1;
+    }
+    PREEMPT_ENABLE();
+    return 0;
+}
+
+static inline int spin_trylock_irqsave(struct spinlock *lock, unsigned long *flags)
+{
+    PREEMPT_DISABLE();
+    *flags = __irq_save();
+    if(__spin_trylock(lock)) {
+        return 1;
+    }
+    __irq_restore(*flags);
+    PREEMPT_ENABLE();
+    return 0;
+}
+
+static inline int spin_trylock_stat(struct spinlock *lock, struct lockstat *site)
+{
+    if(spin_trylock(lock)) {
+        lockstat_acquire(lock, site, 0, 0);
+        return 1;
+    }
+    return 0;
+}
+
 static inline void spin_unlock(struct spinlock *lock)
 {
     __spin_unlock(lock);
@@ -58,4 +313,56 @@ static inline void spin_unlock_irqrestore(struct spinlock *lock, unsigned long f
     PREEMPT_ENABLE();
 }
 
+static inline void spin_unlock_irqrestore_stat(struct spinlock *lock, unsigned long flags)
+{
+    lockstat_release(lock);
+    spin_unlock_irqrestore(lock, flags);
+}
+
+static inline void spin_unlock_stat(struct spinlock *lock)
+{
+    lockstat_release(lock);
+    spin_unlock(lock);
+}
+
+static inline void write_lock(struct rwlock *lock)
+{
+    PREEMPT_DISABLE();
+    __write_lock(lock);
+}
+
+static inline unsigned long write_lock_irqsave(struct rwlock *lock)
+{
+    unsigned long flags;
+    PREEMPT_DISABLE();
+    flags = __irq_save();
+    __write_lock(lock);
+    return flags;
+}
+
+static inline int write_trylock_irqsave(struct rwlock *lock, unsigned long *flags)
+{
+    PREEMPT_DISABLE();
+    *flags = __irq_save();
+    if(__write_trylock(lock)) {
+        return 1;
+    }
+    __irq_restore(*flags);
+    PREEMPT_ENABLE();
+    return 0;
+}
+
+static inline void write_unlock(struct rwlock *lock)
+{
+    __write_unlock(lock);
+    PREEMPT_ENABLE();
+}
+
+static inline void write_unlock_irqrestore(struct rwlock *lock, unsigned long flags)
+{
+    __write_unlock(lock);
+    __irq_restore(flags);
+    PREEMPT_ENABLE();
+}
+
 #endif
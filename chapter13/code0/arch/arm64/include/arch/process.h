@@ -17,6 +17,7 @@
 
 #include "cake/types.h"
 #include "arch/bare-metal.h"
+#include "arch/fpsimd.h"
 
 #define PROCESS_STACK_SAVE_REGISTERS(p) \
     (((struct stack_save_registers *) ((((unsigned long) p->stack) + STACK_SIZE))) - 1)
@@ -35,6 +36,9 @@ struct cpu_context {
     unsigned long fp;
     unsigned long sp;
     unsigned long pc;
+    unsigned long fpsimd_flags;
+    unsigned long fpsimd_cpu;
+    struct fpsimd_state fpsimd;
 };
 
 struct stack_save_registers {
@@ -21,9 +21,11 @@
 #define CURRENT             __current()
 #define SCHEDULE_CURRENT    __schedule_current_init
 #define FORK_PREEMPT_COUNT  (2)
+#define FPSIMD_SWITCH       fpsimd_switch
 
 struct process *__cpu_switch_to(struct process *prev, struct process *next);
 struct process *__current();
+void fpsimd_switch(struct process *prev);
 void __schedule_current_init();
 
 
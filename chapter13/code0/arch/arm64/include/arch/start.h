@@ -17,6 +17,7 @@
 
 #define PSR_MODE_EL0t   0b0000
 
+extern void fpsimd_exec();
 extern void memset(void *dest, int c, unsigned long count);
 
 static inline void start_thread(struct stack_save_registers *ssr, unsigned long pc,
@@ -26,6 +27,7 @@ static inline void start_thread(struct stack_save_registers *ssr, unsigned long
     ssr->pc = pc;
     ssr->pstate = PSR_MODE_EL0t;
     ssr->sp = sp;
+    fpsimd_exec();
 }
 
 #endif
@@ -0,0 +1,48 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _ARCH_TIMER_H
+#define _ARCH_TIMER_H
+
+#define TIMER_COUNT     __timer_count
+#define TIMER_FREQUENCY __timer_frequency
+
+#define TIMER_CTL_ENABLE    (0b001)
+#define TIMER_CTL_IMASK     (0b010)
+
+static inline unsigned long __timer_count()
+{
+    unsigned long count;
+    asm volatile("isb\n\tmrs %0, cntvct_el0" : "=r" (count) : : "memory");
+    return count;
+}
+
+static inline unsigned long __timer_frequency()
+{
+    unsigned long frequency;
+    asm volatile("mrs %0, cntfrq_el0" : "=r" (frequency));
+    return frequency;
+}
+
+static inline void __timer_set_control(unsigned long control)
+{
+    asm volatile("msr cntp_ctl_el0, %0\n\tisb" : : "r" (control) : "memory");
+}
+
+static inline void __timer_set_countdown(unsigned long countdown)
+{
+    asm volatile("msr cntp_tval_el0, %0\n\tisb" : : "r" (countdown) : "memory");
+}
+
+#endif
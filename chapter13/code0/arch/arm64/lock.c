@@ -0,0 +1,171 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config/config.h"
+#include "cake/compiler.h"
+#include "cake/error.h"
+#include "cake/lock.h"
+#include "cake/schedule.h"
+#include "arch/atomic.h"
+#include "arch/barrier.h"
+#include "arch/cache.h"
+#include "arch/lock.h"
+#include "arch/smp.h"
+#include "arch/timer.h"
+#include "user/spinbench.h"
+
+#define QNODE_DEPTH         (4)
+#define QSPIN_LOCKED_MASK   (0xFFFFFFFFUL)
+#define QSPIN_TAIL_SHIFT    (32)
+
+struct spinbench {
+    struct spinlock lock;
+    unsigned long count;
+    unsigned long total;
+} __attribute__((__aligned__(L1_CACHE_BYTES)));
+
+struct qnode {
+    unsigned long next;
+    unsigned long locked;
+    unsigned long count;
+} __attribute__((__aligned__(L1_CACHE_BYTES)));
+
+static inline struct qnode *decode_tail(unsigned long tail);
+static inline unsigned long encode_tail(unsigned long cpu, unsigned long index);
+static inline unsigned long __spin_until_clear(volatile unsigned long *ptr, unsigned long mask);
+static inline unsigned long __spin_until_nonzero(volatile unsigned long *ptr);
+
+static struct spinbench spinbenches[NUM_SPINBENCH];
+static struct qnode qnodes[NUM_CPUS][QNODE_DEPTH];
+
+static inline struct qnode *decode_tail(unsigned long tail)
+{
+    unsigned long index = (tail >> QSPIN_TAIL_SHIFT) - 1;
+    return &(qnodes[index / QNODE_DEPTH][index % QNODE_DEPTH]);
+}
+
+static inline unsigned long encode_tail(unsigned long cpu, unsigned long index)
+{
+    return ((cpu * QNODE_DEPTH) + index + 1) << QSPIN_TAIL_SHIFT;
+}
+
+static inline unsigned long __spin_until_clear(volatile unsigned long *ptr, unsigned long mask)
+{
+    unsigned long val;
+    asm volatile(
+        "   ldar    %0, %1\n"
+        "   tst     %0, %2\n"
+        "   b.eq    2f\n"
+        "   sevl\n"
+        "1: wfe\n"
+        "   ldaxr   %0, %1\n"
+        "   tst     %0, %2\n"
+        "   b.ne    1b\n"
+        "2:"
+        : "=&r" (val)
+        : "Q" (*ptr), "r" (mask)
+        : "cc", "memory");
+    return val;
+}
+
+static inline unsigned long __spin_until_nonzero(volatile unsigned long *ptr)
+{
+    unsigned long val;
+    asm volatile(
+        "   ldar    %0, %1\n"
+        "   cbnz    %0, 2f\n"
+        "   sevl\n"
+        "1: wfe\n"
+        "   ldaxr   %0, %1\n"
+        "   cbz     %0, 1b\n"
+        "2:"
+        : "=&r" (val)
+        : "Q" (*ptr)
+        : "memory");
+    return val;
+}
+
+void queued_spin_lock_slowpath(struct spinlock *lock)
+{
+    unsigned long cpu, index, tail, old, new;
+    struct qnode *node, *next;
+    volatile unsigned long *word = (volatile unsigned long *) lock;
+    cpu = SMP_ID();
+    index = qnodes[cpu][0].count++;
+    node = &(qnodes[cpu][index]);
+    tail = encode_tail(cpu, index);
+    WRITE_ONCE(node->next, 0);
+    WRITE_ONCE(node->locked, 0);
+    SMP_WMB();
+    while(1) {
+        old = READ_ONCE(*word);
+        new = old ? ((old & QSPIN_LOCKED_MASK) | tail) : QSPIN_LOCKED;
+        if(CMPXCHG_RELAXED(word, old, new) == old) {
+            break;
+        }
+    }
+    if(!old) {
+        goto acquired;
+    }
+    SMP_MB();
+    if(old >> QSPIN_TAIL_SHIFT) {
+        WRITE_ONCE(decode_tail(old)->next, (unsigned long) node);
+        __spin_until_nonzero(&(node->locked));
+    }
+    old = __spin_until_clear(word, QSPIN_LOCKED_MASK);
+    while((old >> QSPIN_TAIL_SHIFT) == (tail >> QSPIN_TAIL_SHIFT)) {
+        if(CMPXCHG_RELAXED(word, old, QSPIN_LOCKED) == old) {
+            goto acquired;
+        }
+        old = READ_ONCE(*word);
+    }
+    WRITE_ONCE(lock->owner, QSPIN_LOCKED);
+    next = (struct qnode *) __spin_until_nonzero(&(node->next));
+    SMP_MB();
+    WRITE_ONCE(next->locked, 1);
+acquired:
+    SMP_MB();
+    qnodes[cpu][0].count--;
+}
+
+long sys_spinbench(unsigned long kind, unsigned long iterations)
+{
+    unsigned long start, elapsed;
+    struct spinbench *bench;
+    if(kind >= NUM_SPINBENCH) {
+        return -EINVAL;
+    }
+    bench = &(spinbenches[kind]);
+    if(!iterations) {
+        return XCHG_RELAXED(&(bench->total), 0);
+    }
+    start = TIMER_COUNT();
+    for(unsigned long i = 0; i < iterations; i++) {
+        PREEMPT_DISABLE();
+        if(kind == SPINBENCH_QUEUED) {
+            __queued_spin_lock(&(bench->lock));
+            bench->count++;
+            __queued_spin_unlock(&(bench->lock));
+        }
+        else {
+            __ticket_spin_lock(&(bench->lock));
+            bench->count++;
+            __ticket_spin_unlock(&(bench->lock));
+        }
+        PREEMPT_ENABLE();
+    }
+    elapsed = TIMER_COUNT() - start;
+    ATOMIC_LONG_ADD(&(bench->total), elapsed);
+    return elapsed;
+}
@@ -19,11 +19,14 @@
 
 #include "config/config.h"
 #include "cake/bitops.h"
+#include "cake/error.h"
 #include "cake/fork.h"
 #include "cake/process.h"
+#include "arch/fpsimd.h"
 #include "arch/process.h"
 #include "arch/schedule.h"
 #include "user/fork.h"
+#include "user/sched.h"
 
 extern void __ret_from_fork();
 extern void memset(void *dest, int c, unsigned long count);
@@ -35,8 +38,15 @@ int copy_arch_context(unsigned long flags,
 {
     struct stack_save_registers *ssr = PROCESS_STACK_SAVE_REGISTERS(p);
     memset(&(p->context), 0, sizeof(struct cpu_context));
+    p->context.fpsimd_cpu = NUM_CPUS;
     p->preempt_count = FORK_PREEMPT_COUNT;
+    p->need_resched = 0;
     p->priority = CLONE_PRIORITY(flags);
+    p->policy = CLONE_SCHED(flags);
+    p->rt_priority = CLONE_RT_PRIORITY(flags);
+    if(p->policy > SCHED_RR || (p->policy != SCHED_NORMAL && !p->rt_priority)) {
+        return -EINVAL;
+    }
     if(flags & CLONE_CAKETHREAD) {
         memset(ssr, 0, sizeof(*ssr));
         p->context.x19 = thread_input;
@@ -46,6 +56,9 @@ int copy_arch_context(unsigned long flags,
     }
     else {
         *ssr = *PROCESS_STACK_SAVE_REGISTERS(CURRENT);
+        fpsimd_save_current();
+        p->context.fpsimd = CURRENT->context.fpsimd;
+        p->context.fpsimd_flags = CURRENT->context.fpsimd_flags & FPSIMD_USED;
         ssr->regs[0] = 0;
         if(arg) {
             ssr->sp = arg;
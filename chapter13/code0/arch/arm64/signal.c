@@ -21,9 +21,11 @@
 #include "cake/process.h"
 #include "cake/signal.h"
 #include "cake/user.h"
+#include "arch/fpsimd.h"
 #include "arch/process.h"
 #include "arch/schedule.h"
 
+#define FPSIMD_MAGIC        0x46508001
 #define INSTRUCTION_SIZE    4
 
 struct user_layout;
@@ -40,6 +42,13 @@ struct aarch64_ctx {
     u32 size;
 };
 
+struct user_fpsimd_context {
+    struct aarch64_ctx head;
+    u32 fpsr;
+    u32 fpcr;
+    u64 vregs[64] __attribute__((__aligned__(16)));
+};
+
 struct user_sigcontext {
     u64 fault_address;
     u64 regs[31];
@@ -73,6 +82,7 @@ struct user_layout {
     struct user_record *record;
     unsigned long size;
     unsigned long limit;
+    unsigned long fpsimd_offset;
     unsigned long end_offset;
 };
 
@@ -97,6 +107,7 @@ static void run_user_sighandler(struct stack_save_registers *ssr, struct cakesig
 {
     unsigned long sp;
     struct aarch64_ctx *aactx;
+    struct user_fpsimd_context *fpctx;
     struct user_layout user;
     struct user_frame *frame;
     struct process *current = CURRENT;
@@ -116,6 +127,15 @@ static void run_user_sighandler(struct stack_save_registers *ssr, struct cakesig
     frame->context.uc_mcontext.pc = ssr->pc;
     frame->context.uc_mcontext.pstate = ssr->pstate;
     copy_to_user(&frame->context.uc_sigmask, blocked, sizeof(*blocked));
+    if(user.fpsimd_offset) {
+        fpsimd_save_current();
+        fpctx = (struct user_fpsimd_context *) (((unsigned long) frame) + user.fpsimd_offset);
+        fpctx->head.magic = FPSIMD_MAGIC;
+        fpctx->head.size = sizeof(*fpctx);
+        fpctx->fpsr = current->context.fpsimd.fpsr;
+        fpctx->fpcr = current->context.fpsimd.fpcr;
+        copy_to_user(fpctx->vregs, current->context.fpsimd.vregs, sizeof(fpctx->vregs));
+    }
     aactx = (struct aarch64_ctx *) (((unsigned long) frame) + user.end_offset);
     aactx->magic = 0;
     aactx->size = 0;
@@ -136,6 +156,10 @@ static unsigned long signal_frame(struct user_layout *user,
     padded_size = ROUND_UP(sizeof(struct aarch64_ctx), 16);
     user->size = OFFSETOF(struct user_frame, context.uc_mcontext.reserved);
     user->limit = user->size + reserved_size;
+    if(CURRENT->context.fpsimd_flags & FPSIMD_USED) {
+        user->fpsimd_offset = user->size;
+        user->size += ROUND_UP(sizeof(struct user_fpsimd_context), 16);
+    }
     user->end_offset = user->size;
     user->size += padded_size;
     user->limit = user->size;
@@ -149,10 +173,18 @@ static unsigned long signal_frame(struct user_layout *user,
 int sys_sigreturn()
 {
     unsigned long blocked;
+    struct user_fpsimd_context *fpctx;
     struct process *current = CURRENT;
     struct stack_save_registers *ssr = PROCESS_STACK_SAVE_REGISTERS(current);
     struct user_frame *frame = (struct user_frame *) ssr->sp;
     blocked = frame->context.uc_sigmask;
+    fpctx = (struct user_fpsimd_context *) frame->context.uc_mcontext.reserved;
+    if(fpctx->head.magic == FPSIMD_MAGIC && fpctx->head.size == sizeof(*fpctx)) {
+        fpsimd_flush_current();
+        current->context.fpsimd.fpsr = fpctx->fpsr;
+        current->context.fpsimd.fpcr = fpctx->fpcr;
+        copy_from_user(current->context.fpsimd.vregs, fpctx->vregs, sizeof(fpctx->vregs));
+    }
     set_blocked_signals(current, blocked);
     for(int i = 0; i < 31; i++) {
         ssr->regs[i] = frame->context.uc_mcontext.regs[i];
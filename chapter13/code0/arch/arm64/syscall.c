@@ -14,8 +14,10 @@
 
 #include "arch/page.h"
 #include "user/cpu.h"
+#include "user/lockstat.h"
 #include "user/signal.h"
 #include "user/syscall.h"
+#include "user/time.h"
 
 extern int sys_clone(unsigned long flags, unsigned long thread_input, unsigned long arg);
 extern int sys_cpustat(unsigned long cpu, struct user_cpuinfo *cpuinfo);
@@ -23,10 +25,17 @@ extern int sys_exec(void *user_function);
 extern void sys_exit(int code);
 extern int sys_getpid();
 extern long sys_ioctl(int fd, unsigned int request, unsigned long arg);
+extern int sys_lockstat(unsigned long index, struct user_lockstat *lockstat);
+extern int sys_memstat(unsigned long kind, unsigned long index, void *info);
+extern long sys_nanosleep(struct timespec *request, struct timespec *remain);
+extern int sys_sched_getaffinity(int pid, unsigned long size, unsigned long *cpumask);
+extern int sys_sched_setaffinity(int pid, unsigned long size, unsigned long *cpumask);
+extern int sys_sched_setscheduler(int pid, int policy, int priority);
 extern long sys_read(int fd, char *buffer, unsigned long count);
 extern int sys_sigaction(int signo, struct sigaction *sigaction, struct sigaction *unused);
 extern int sys_sigprocmask(unsigned long how, unsigned long *newset, unsigned long *oldset);
 extern void sys_sigreturn();
+extern long sys_spinbench(unsigned long kind, unsigned long iterations);
 extern int sys_waitpid(int pid, int *status, int options);
 extern long sys_write(unsigned int fd, char *user, unsigned long count);
 
@@ -44,4 +53,11 @@ void * sys_call_table [NUM_SYSCALLS] __attribute__((__aligned__(PAGE_SIZE))) = {
     [SYSCALL_WAITPID] = sys_waitpid,
     [SYSCALL_EXIT] = sys_exit,
     [SYSCALL_CPUSTAT] = sys_cpustat,
+    [SYSCALL_MEMSTAT] = sys_memstat,
+    [SYSCALL_NANOSLEEP] = sys_nanosleep,
+    [SYSCALL_SETSCHEDULER] = sys_sched_setscheduler,
+    [SYSCALL_SETAFFINITY] = sys_sched_setaffinity,
+    [SYSCALL_GETAFFINITY] = sys_sched_getaffinity,
+    [SYSCALL_SPINBENCH] = sys_spinbench,
+    [SYSCALL_LOCKSTAT] = sys_lockstat,
 };
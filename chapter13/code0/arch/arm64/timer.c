@@ -0,0 +1,62 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config/config.h"
+#include "arch/smp.h"
+#include "arch/timer.h"
+
+int generic_timer_start();
+
+static unsigned int enabled;
+static unsigned long interval;
+
+int generic_timer_init()
+{
+    unsigned long frequency = __timer_frequency();
+    if(!TIMER_GENERIC || !frequency) {
+        return 0;
+    }
+    interval = frequency / TIMER_HZ;
+    enabled = 1;
+    return generic_timer_start();
+}
+
+void generic_timer_interrupt()
+{
+    __timer_set_countdown(interval);
+}
+
+int generic_timer_start()
+{
+    if(!enabled) {
+        return 0;
+    }
+    __timer_set_countdown(interval);
+    __timer_set_control(TIMER_CTL_ENABLE);
+    return 1;
+}
+
+int timer_nohz_stop()
+{
+    if(!enabled || !SMP_ID()) {
+        return 0;
+    }
+    __timer_set_control(TIMER_CTL_IMASK);
+    return 1;
+}
+
+void timer_nohz_restart()
+{
+    generic_timer_start();
+}
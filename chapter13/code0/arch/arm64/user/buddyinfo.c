@@ -0,0 +1,83 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "user/memory.h"
+
+#define STDOUT  (1)
+
+unsigned long libc_strlen(const char *s);
+void exit(int code);
+int memstat(unsigned long kind, unsigned long index, void *info);
+void write(int fd, char *buffer, unsigned long count);
+
+static void ltoa(unsigned long l, char *a);
+static void print_stat(char *label, unsigned long value);
+
+int buddyinfo()
+{
+    struct user_buddyinfo buddyinfo;
+    if(!memstat(MEMSTAT_BUDDY, 0, &buddyinfo)) {
+        exit(1);
+    }
+    for(unsigned long order = 0; order < buddyinfo.orders; order++) {
+        print_stat("\nORDER: ", order);
+        print_stat("FREE BLOCKS: ", buddyinfo.freeblocks[order]);
+        print_stat("PER-CPU BLOCKS: ", buddyinfo.cachedblocks[order]);
+        print_stat("ZEROED BLOCKS: ", buddyinfo.zeroedblocks[order]);
+        print_stat("MOVABLE BLOCKS: ", buddyinfo.movableblocks[order]);
+    }
+    print_stat("\nPER-CPU REFILLS: ", buddyinfo.refills);
+    print_stat("PER-CPU DRAINS: ", buddyinfo.drains);
+    print_stat("ZEROED HITS: ", buddyinfo.zeroed_hits);
+    print_stat("ZEROED MISSES: ", buddyinfo.zeroed_misses);
+    print_stat("CONTIG PAGES: ", buddyinfo.contig_pages);
+    print_stat("CONTIG FREE: ", buddyinfo.contig_free);
+    print_stat("CONTIG ALLOCS: ", buddyinfo.contig_allocs);
+    print_stat("CONTIG FAILURES: ", buddyinfo.contig_failures);
+    print_stat("COMPACT SUCCESSES: ", buddyinfo.compact_successes);
+    print_stat("COMPACT FAILURES: ", buddyinfo.compact_failures);
+    print_stat("PAGES MIGRATED: ", buddyinfo.compact_migrated);
+    print_stat("LOCK ACQUIRES: ", buddyinfo.lock_acquires);
+    print_stat("LOCK WAIT: ", buddyinfo.lock_wait);
+    exit(0);
+    return 0;
+}
+
+static void ltoa(unsigned long l, char *a)
+{
+    int temp_size = 0;
+    char c, temp[20];
+    do {
+        c = l % 10;
+        c = c + 0x30;
+        temp[temp_size++] = c;
+        l /= 10;
+    } while(l);
+    while(temp_size--) {
+        *(a++) = temp[temp_size];
+    }
+    *(a++) = '\0';
+}
+
+static void print_stat(char *label, unsigned long value)
+{
+    unsigned long len;
+    char statsbuf[64];
+    ltoa(value, statsbuf);
+    len = libc_strlen(statsbuf);
+    statsbuf[len] = '\n';
+    statsbuf[len + 1] = '\0';
+    write(STDOUT, label, libc_strlen(label) + 1);
+    write(STDOUT, statsbuf, len + 2);
+}
@@ -19,6 +19,20 @@ struct user_cpuinfo {
     unsigned long cpu;
     unsigned long weight;
     unsigned long pid;
+    unsigned long runnable;
+    unsigned long schedules;
+    unsigned long schedule_time;
+    unsigned long pulls;
+    unsigned long pull_failures;
+    unsigned long pull_hot;
+    unsigned long load_avg;
+    unsigned long balance_pulls;
+    unsigned long ticks;
+    unsigned long wakeups;
+    unsigned long nohz_skipped;
+    unsigned long wakeup_preempts;
+    unsigned long resched_ipis;
+    unsigned long isolated;
 };
 
 #endif 
@@ -20,6 +20,8 @@
 #define CLONE_VM                    0b00000010 
 #define CLONE_SIGNAL                0b00000100 
 #define CLONE_FILES                 0b00001000 
+#define CLONE_SCHED_FIFO            0b00010000
+#define CLONE_SCHED_RR              0b00100000
 #define CLONE_THREAD                (CLONE_VM | CLONE_SIGNAL | CLONE_FILES)
 
 #define CLONE_PRIORITY_MAX          ((3))
@@ -28,4 +30,13 @@
 #define CLONE_PRIORITY_USER         ((1) << (CLONE_PRIORITY_SHIFT))
 #define CLONE_PRIORITY(x)           (((x) >> (CLONE_PRIORITY_SHIFT)) & CLONE_PRIORITY_MAX)
 
+#define CLONE_SCHED_MASK            ((0b11))
+#define CLONE_SCHED_SHIFT           ((4))
+#define CLONE_SCHED(x)              (((x) >> (CLONE_SCHED_SHIFT)) & CLONE_SCHED_MASK)
+
+#define CLONE_RT_PRIORITY_MAX       ((15))
+#define CLONE_RT_PRIORITY_SHIFT     ((16))
+#define CLONE_RT_PRIORITY_WORK      ((8) << (CLONE_RT_PRIORITY_SHIFT))
+#define CLONE_RT_PRIORITY(x)        (((x) >> (CLONE_RT_PRIORITY_SHIFT)) & CLONE_RT_PRIORITY_MAX)
+
 #endif
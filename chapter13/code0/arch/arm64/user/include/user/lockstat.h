@@ -0,0 +1,32 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _USER_LOCKSTAT_H
+#define _USER_LOCKSTAT_H
+
+#define LOCKSTAT_NAME_LEN   (32)
+
+struct user_lockstat {
+    char class[LOCKSTAT_NAME_LEN];
+    char function[LOCKSTAT_NAME_LEN];
+    unsigned long line;
+    unsigned long acquisitions;
+    unsigned long contended;
+    unsigned long wait_total;
+    unsigned long wait_max;
+    unsigned long hold_total;
+    unsigned long hold_max;
+};
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _USER_MEMORY_H
+#define _USER_MEMORY_H
+
+#define MEMSTAT_BUDDY       (0)
+#define MEMSTAT_SLAB        (1)
+#define MEMSTAT_MAX_ORDERS  (16)
+#define MEMSTAT_NAME_LEN    (32)
+
+struct user_buddyinfo {
+    unsigned long orders;
+    unsigned long freeblocks[MEMSTAT_MAX_ORDERS];
+    unsigned long cachedblocks[MEMSTAT_MAX_ORDERS];
+    unsigned long zeroedblocks[MEMSTAT_MAX_ORDERS];
+    unsigned long movableblocks[MEMSTAT_MAX_ORDERS];
+    unsigned long refills;
+    unsigned long drains;
+    unsigned long zeroed_hits;
+    unsigned long zeroed_misses;
+    unsigned long contig_pages;
+    unsigned long contig_free;
+    unsigned long contig_allocs;
+    unsigned long contig_failures;
+    unsigned long compact_successes;
+    unsigned long compact_failures;
+    unsigned long compact_migrated;
+    unsigned long lock_acquires;
+    unsigned long lock_wait;
+};
+
+struct user_slabinfo {
+    char name[MEMSTAT_NAME_LEN];
+    unsigned long objsize;
+    unsigned long batchsize;
+    unsigned long pageorder;
+    unsigned long capacity;
+    unsigned long freecount;
+    unsigned long allocs;
+    unsigned long frees;
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long grows;
+    unsigned long shrinks;
+    unsigned long lock_wait;
+};
+
+#endif
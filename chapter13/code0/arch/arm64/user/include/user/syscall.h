@@ -28,6 +28,13 @@
 #define SYSCALL_WAITPID         (10)
 #define SYSCALL_EXIT            (11)
 #define SYSCALL_CPUSTAT         (12)
-#define NUM_SYSCALLS            (13)
+#define SYSCALL_MEMSTAT         (13)
+#define SYSCALL_NANOSLEEP       (14)
+#define SYSCALL_SETSCHEDULER    (15)
+#define SYSCALL_SETAFFINITY     (16)
+#define SYSCALL_GETAFFINITY     (17)
+#define SYSCALL_SPINBENCH       (18)
+#define SYSCALL_LOCKSTAT        (19)
+#define NUM_SYSCALLS            (20)
 
 #endif
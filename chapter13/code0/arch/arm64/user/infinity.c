@@ -12,20 +12,23 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "user/time.h"
+
 #define STDOUT  (1)
 
 void exit(int code);
+long nanosleep(struct timespec *request, struct timespec *remain);
 unsigned long write(int fd, char *buffer, unsigned long count);
 
 int infinity()
 {
-    int delay = 10000000;
-    char wait;
+    struct timespec delay = {
+        .sec = 1,
+        .nsec = 0
+    };
     while(1) {
         write(STDOUT, "infinity\n", 10); 
-        for(int i = 0; i < delay; i++) {
-            *(&wait) = '\0';
-        }
+        nanosleep(&delay, 0);
     }
     exit(0);
     return 0;
@@ -13,7 +13,9 @@
  */
 
 #include "user/cpu.h"
+#include "user/lockstat.h"
 #include "user/signal.h"
+#include "user/time.h"
 
 extern int __clone(unsigned long flags, unsigned long thread_input, unsigned long arg);
 extern int __cpustat(unsigned long cpu, struct user_cpuinfo *cpuinfo);
@@ -21,10 +23,17 @@ extern int __exec(int (*user_function)(void));
 extern void __exit(int code);
 extern int __getpid();
 extern int __ioctl(int fd, unsigned int request, void *arg);
+extern int __lockstat(unsigned long index, struct user_lockstat *lockstat);
+extern int __memstat(unsigned long kind, unsigned long index, void *info);
+extern long __nanosleep(struct timespec *request, struct timespec *remain);
 extern long __read(int fd, char *buffer, unsigned long count);
+extern int __sched_getaffinity(int pid, unsigned long size, unsigned long *cpumask);
+extern int __sched_setaffinity(int pid, unsigned long size, unsigned long *cpumask);
+extern int __sched_setscheduler(int pid, int policy, int priority);
 extern int __sigaction(int signo, struct sigaction *sigaction, struct sigaction *unused);
 extern int __sigprocmask(unsigned long how, unsigned long *newset, unsigned long *oldset);
 extern void __sigreturn();
+extern long __spinbench(unsigned long kind, unsigned long iterations);
 extern int __waitpid(int pid, int *status, int options);
 extern long __write(int fd, char *buffer, unsigned long count);
 
@@ -82,11 +91,41 @@ int ioctl(int fd, unsigned int request, void *arg)
     return __ioctl(fd, request, arg);
 }
 
+int lockstat(unsigned long index, struct user_lockstat *lockstat)
+{
+    return __lockstat(index, lockstat);
+}
+
+int memstat(unsigned long kind, unsigned long index, void *info)
+{
+    return __memstat(kind, index, info);
+}
+
+long nanosleep(struct timespec *request, struct timespec *remain)
+{
+    return __nanosleep(request, remain);
+}
+
 long read(int fd, char *buffer, unsigned long count)
 {
     return __read(fd, buffer, count);
 }
 
+int sched_getaffinity(int pid, unsigned long size, unsigned long *cpumask)
+{
+    return __sched_getaffinity(pid, size, cpumask);
+}
+
+int sched_setaffinity(int pid, unsigned long size, unsigned long *cpumask)
+{
+    return __sched_setaffinity(pid, size, cpumask);
+}
+
+int sched_setscheduler(int pid, int policy, int priority)
+{
+    return __sched_setscheduler(pid, policy, priority);
+}
+
 int signal(int signo, void (*fn)(int))
 {
     struct sigaction sigaction;
@@ -100,6 +139,11 @@ int sigprocmask(unsigned long how, unsigned long *newset, unsigned long *oldset)
     return __sigprocmask(how, newset, oldset);
 }
 
+long spinbench(unsigned long kind, unsigned long iterations)
+{
+    return __spinbench(kind, iterations);
+}
+
 int waitpid(int pid, int *status, int options)
 {
     return __waitpid(pid, status, options);
@@ -0,0 +1,102 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "user/cpu.h"
+#include "user/fork.h"
+#include "user/spinbench.h"
+#include "user/wait.h"
+
+#define STDOUT          (1)
+#define ITERATIONS      (100000)
+
+unsigned long libc_strlen(const char *s);
+int clone(unsigned long flags);
+int cpustat(unsigned long cpu, struct user_cpuinfo *cpuinfo);
+void exit(int code);
+int sched_setaffinity(int pid, unsigned long size, unsigned long *cpumask);
+long spinbench(unsigned long kind, unsigned long iterations);
+long waitpid(int pid, int *status, int options);
+void write(int fd, char *buffer, unsigned long count);
+
+static void ltoa(unsigned long l, char *a);
+static void print_stat(char *label, unsigned long value);
+static unsigned long run_workers(unsigned long kind, unsigned long workers);
+
+int lockbench()
+{
+    unsigned long ncpus;
+    struct user_cpuinfo cpuinfo;
+    ncpus = 0;
+    while(cpustat(ncpus, &cpuinfo)) {
+        ncpus++;
+    }
+    print_stat("CPUS: ", ncpus);
+    print_stat("ITERATIONS PER WORKER: ", ITERATIONS);
+    print_stat("TICKET UNCONTENDED COUNTS: ", run_workers(SPINBENCH_TICKET, 1));
+    print_stat("QUEUED UNCONTENDED COUNTS: ", run_workers(SPINBENCH_QUEUED, 1));
+    print_stat("TICKET CONTENDED COUNTS: ", run_workers(SPINBENCH_TICKET, ncpus));
+    print_stat("QUEUED CONTENDED COUNTS: ", run_workers(SPINBENCH_QUEUED, ncpus));
+    exit(0);
+    return 0;
+}
+
+static void ltoa(unsigned long l, char *a)
+{
+    int temp_size = 0;
+    char c, temp[20];
+    do {
+        c = l % 10;
+        c = c + 0x30;
+        temp[temp_size++] = c;
+        l /= 10;
+    } while(l);
+    while(temp_size--) {
+        *(a++) = temp[temp_size];
+    }
+    *(a++) = '\0';
+}
+
+static void print_stat(char *label, unsigned long value)
+{
+    unsigned long len;
+    char statsbuf[64];
+    ltoa(value, statsbuf);
+    len = libc_strlen(statsbuf);
+    statsbuf[len] = '\n';
+    statsbuf[len + 1] = '\0';
+    write(STDOUT, label, libc_strlen(label) + 1);
+    write(STDOUT, statsbuf, len + 2);
+}
+
+static unsigned long run_workers(unsigned long kind, unsigned long workers)
+{
+    int status;
+    unsigned long cpumask, spawned;
+    spinbench(kind, 0);
+    for(spawned = 0; spawned < workers; spawned++) {
+        status = clone(CLONE_STANDARD | CLONE_PRIORITY_USER);
+        if(status == 0) {
+            cpumask = (1UL << spawned);
+            sched_setaffinity(0, sizeof(cpumask), &cpumask);
+            exit(spinbench(kind, ITERATIONS) < 0);
+        }
+        if(status < 0) {
+            break;
+        }
+    }
+    for(unsigned long reaped = 0; reaped < spawned; reaped++) {
+        waitpid(-1, &status, 0);
+    }
+    return spawned ? (spinbench(kind, 0) / spawned) : 0;
+}
@@ -0,0 +1,148 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "user/cpu.h"
+#include "user/fork.h"
+#include "user/wait.h"
+
+#define STDOUT          (1)
+#define BUFFER_SIZE     (16384)
+#define ITERATIONS      (64)
+#define WORKERS_PER_CPU (2)
+
+unsigned long libc_strlen(const char *s);
+int clone(unsigned long flags);
+int cpustat(unsigned long cpu, struct user_cpuinfo *cpuinfo);
+void exit(int code);
+long waitpid(int pid, int *status, int options);
+void write(int fd, char *buffer, unsigned long count);
+
+extern unsigned long __counter();
+extern unsigned long __counter_frequency();
+extern unsigned int __neon_checksum(unsigned char *buffer, unsigned long count);
+extern void __neon_xor(unsigned char *dest, unsigned char *a, unsigned char *b,
+    unsigned long count);
+
+static void ltoa(unsigned long l, char *a);
+static void print_stat(char *label, unsigned long value);
+static unsigned int scalar_checksum(unsigned char *buffer, unsigned long count);
+static void scalar_xor(unsigned char *dest, unsigned char *a, unsigned char *b,
+    unsigned long count);
+
+static unsigned char left[BUFFER_SIZE] __attribute__((__aligned__(16)));
+static unsigned char right[BUFFER_SIZE] __attribute__((__aligned__(16)));
+static unsigned char out[BUFFER_SIZE] __attribute__((__aligned__(16)));
+
+int neonbench()
+{
+    int status;
+    unsigned int expected, sum;
+    unsigned long start, scalar_counts, neon_counts, ncpus, spawned, reaped, failures;
+    struct user_cpuinfo cpuinfo;
+    for(unsigned long i = 0; i < BUFFER_SIZE; i++) {
+        left[i] = (i * 7) + 3;
+        right[i] = (i * 13) + 5;
+    }
+    expected = scalar_checksum(left, BUFFER_SIZE);
+    start = __counter();
+    for(int i = 0; i < ITERATIONS; i++) {
+        scalar_checksum(left, BUFFER_SIZE);
+        scalar_xor(out, left, right, BUFFER_SIZE);
+    }
+    scalar_counts = __counter() - start;
+    start = __counter();
+    for(int i = 0; i < ITERATIONS; i++) {
+        sum = __neon_checksum(left, BUFFER_SIZE);
+        __neon_xor(out, left, right, BUFFER_SIZE);
+    }
+    neon_counts = __counter() - start;
+    print_stat("COUNTER FREQUENCY: ", __counter_frequency());
+    print_stat("SCALAR COUNTS: ", scalar_counts);
+    print_stat("NEON COUNTS: ", neon_counts);
+    print_stat("CHECKSUM MATCH: ", sum == expected);
+    ncpus = 0;
+    while(cpustat(ncpus, &cpuinfo)) {
+        ncpus++;
+    }
+    for(spawned = 0; spawned < ncpus * WORKERS_PER_CPU; spawned++) {
+        status = clone(CLONE_STANDARD | CLONE_PRIORITY_USER);
+        if(status == 0) {
+            for(int i = 0; i < ITERATIONS * 4; i++) {
+                if(__neon_checksum(left, BUFFER_SIZE) != expected) {
+                    exit(1);
+                }
+            }
+            exit(0);
+        }
+        if(status < 0) {
+            break;
+        }
+    }
+    failures = 0;
+    for(reaped = 0; reaped < spawned; reaped++) {
+        waitpid(-1, &status, 0);
+        if(WEXITDECODE(status)) {
+            failures++;
+        }
+    }
+    print_stat("CONCURRENT WORKERS: ", spawned);
+    print_stat("CONCURRENT FAILURES: ", failures);
+    exit(0);
+    return 0;
+}
+
+static void ltoa(unsigned long l, char *a)
+{
+    int temp_size = 0;
+    char c, temp[20];
+    do {
+        c = l % 10;
+        c = c + 0x30;
+        temp[temp_size++] = c;
+        l /= 10;
+    } while(l);
+    while(temp_size--) {
+        *(a++) = temp[temp_size];
+    }
+    *(a++) = '\0';
+}
+
+static void print_stat(char *label, unsigned long value)
+{
+    unsigned long len;
+    char statsbuf[64];
+    ltoa(value, statsbuf);
+    len = libc_strlen(statsbuf);
+    statsbuf[len] = '\n';
+    statsbuf[len + 1] = '\0';
+    write(STDOUT, label, libc_strlen(label) + 1);
+    write(STDOUT, statsbuf, len + 2);
+}
+
+static unsigned int scalar_checksum(unsigned char *buffer, unsigned long count)
+{
+    unsigned int sum = 0;
+    for(unsigned long i = 0; i < count; i++) {
+        sum += buffer[i];
+    }
+    return sum;
+}
+
+static void scalar_xor(unsigned char *dest, unsigned char *a, unsigned char *b,
+    unsigned long count)
+{
+    for(unsigned long i = 0; i < count; i++) {
+        dest[i] = a[i] ^ b[i];
+    }
+}
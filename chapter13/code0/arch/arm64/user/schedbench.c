@@ -0,0 +1,122 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "user/cpu.h"
+#include "user/fork.h"
+#include "user/wait.h"
+
+#define STDOUT          (1)
+#define SPIN_DELAY      (200000)
+
+unsigned long libc_strlen(const char *s);
+int clone(unsigned long flags);
+int cpustat(unsigned long cpu, struct user_cpuinfo *cpuinfo);
+void exit(int code);
+long waitpid(int pid, int *status, int options);
+void write(int fd, char *buffer, unsigned long count);
+
+static void ltoa(unsigned long l, char *a);
+static void print_stat(char *label, unsigned long value);
+static void sample(unsigned long *schedules, unsigned long *ticks);
+static void spin();
+
+int schedbench()
+{
+    int status;
+    unsigned long ncpus, nprocs, spawned, reaped;
+    unsigned long schedules, ticks, end_schedules, end_ticks;
+    unsigned long perprocs[] = {4, 40, 400};
+    struct user_cpuinfo cpuinfo;
+    ncpus = 0;
+    while(cpustat(ncpus, &cpuinfo)) {
+        ncpus++;
+    }
+    for(unsigned long i = 0; i < sizeof(perprocs) / sizeof(perprocs[0]); i++) {
+        nprocs = perprocs[i] * ncpus;
+        sample(&schedules, &ticks);
+        for(spawned = 0; spawned < nprocs; spawned++) {
+            status = clone(CLONE_STANDARD | CLONE_PRIORITY_USER);
+            if(status == 0) {
+                spin();
+                exit(0);
+            }
+            if(status < 0) {
+                break;
+            }
+        }
+        for(reaped = 0; reaped < spawned; reaped++) {
+            waitpid(-1, &status, 0);
+        }
+        sample(&end_schedules, &end_ticks);
+        end_schedules -= schedules;
+        end_ticks -= ticks;
+        write(STDOUT, "\n", 2);
+        print_stat("PROCESSES PER CPU: ", perprocs[i]);
+        print_stat("PROCESSES SPAWNED: ", spawned);
+        print_stat("SCHEDULES: ", end_schedules);
+        print_stat("TICKS PER 1000 SCHEDULES: ",
+            end_schedules ? (end_ticks * 1000) / end_schedules : 0);
+    }
+    exit(0);
+    return 0;
+}
+
+static void ltoa(unsigned long l, char *a)
+{
+    int temp_size = 0;
+    char c, temp[20];
+    do {
+        c = l % 10;
+        c = c + 0x30;
+        temp[temp_size++] = c;
+        l /= 10;
+    } while(l);
+    while(temp_size--) {
+        *(a++) = temp[temp_size];
+    }
+    *(a++) = '\0';
+}
+
+static void print_stat(char *label, unsigned long value)
+{
+    unsigned long len;
+    char statsbuf[64];
+    ltoa(value, statsbuf);
+    len = libc_strlen(statsbuf);
+    statsbuf[len] = '\n';
+    statsbuf[len + 1] = '\0';
+    write(STDOUT, label, libc_strlen(label) + 1);
+    write(STDOUT, statsbuf, len + 2);
+}
+
+static void sample(unsigned long *schedules, unsigned long *ticks)
+{
+    unsigned long cpu = 0;
+    struct user_cpuinfo cpuinfo;
+    *schedules = 0;
+    *ticks = 0;
+    while(cpustat(cpu, &cpuinfo)) {
+        *schedules += cpuinfo.schedules;
+        *ticks += cpuinfo.schedule_time;
+        cpu++;
+    }
+}
+
+static void spin()
+{
+    char wait;
+    for(int i = 0; i < SPIN_DELAY; i++) {
+        *(&wait) = '\0';
+    }
+}
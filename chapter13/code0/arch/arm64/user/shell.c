@@ -14,6 +14,7 @@
 
 #include "user/fork.h"
 #include "user/signal.h"
+#include "user/tty.h"
 #include "user/wait.h"
 
 #define STDIN       (0)
@@ -36,11 +37,17 @@ int sigprocmask(unsigned long how, unsigned long *newset, unsigned long *oldset)
 long waitpid(int pid, int *status, int options);
 long write(int fd, char *buffer, unsigned long count);
 
+int buddyinfo();
 int cat();
 int fault();
 int hello();
 int infinity();
+int lockbench();
+int neonbench();
+int schedbench();
 int showcpus();
+int showlocks();
+int slabinfo();
 
 struct program {
     char name[32];
@@ -70,8 +77,8 @@ int shell()
     shell_prompt_len = libc_strlen(shell_prompt) + 1;
     mask = prev_mask = 0;
     shell_pid = getpid();
-    ioctl(STDIN, 0, shell_pid);
-    ioctl(STDOUT, 0, shell_pid);
+    ioctl(STDIN, TTY_IOCTL_SET_LEADER, shell_pid);
+    ioctl(STDOUT, TTY_IOCTL_SET_LEADER, shell_pid);
     signal(SIGCHLD, shell_sigchld_handler);
     libc_sigaddset(&mask, SIGCHLD);
     libc_sigaddset(&prev_mask, SIGINT);
@@ -109,8 +116,8 @@ int shell()
                 if(pid == fg) {
                     if(WIFEXITED(status)) {
                         flags |= WNOHANG;
-                        ioctl(STDIN, 0, shell_pid);
-                        ioctl(STDOUT, 0, shell_pid);
+                        ioctl(STDIN, TTY_IOCTL_SET_LEADER, shell_pid);
+                        ioctl(STDOUT, TTY_IOCTL_SET_LEADER, shell_pid);
                         switch(WEXITDECODE(status)) {
                             case 0:
                             case SIGINT:
@@ -149,7 +156,12 @@ static int shell_clone_exec(char *buffer)
 {
     int pid = 0;
     unsigned long flags = (CLONE_STANDARD | CLONE_PRIORITY_USER);
-    if(!libc_strcmp(buffer, "cat")) {
+    if(!libc_strcmp(buffer, "buddyinfo")) {
+        if((pid = clone(flags)) == 0) {
+            shell_run(buddyinfo);
+        }
+    }
+    else if(!libc_strcmp(buffer, "cat")) {
         if((pid = clone(flags)) == 0) {
             shell_run(cat);
         }
@@ -169,11 +181,36 @@ static int shell_clone_exec(char *buffer)
             shell_run(infinity);
         }
     }
+    else if(!libc_strcmp(buffer, "lockbench")) {
+        if((pid = clone(flags)) == 0) {
+            shell_run(lockbench);
+        }
+    }
+    else if(!libc_strcmp(buffer, "neonbench")) {
+        if((pid = clone(flags)) == 0) {
+            shell_run(neonbench);
+        }
+    }
+    else if(!libc_strcmp(buffer, "schedbench")) {
+        if((pid = clone(flags)) == 0) {
+            shell_run(schedbench);
+        }
+    }
     else if(!libc_strcmp(buffer, "showcpus")) {
         if((pid = clone(flags)) == 0) {
             shell_run(showcpus);
         }
     }
+    else if(!libc_strcmp(buffer, "showlocks")) {
+        if((pid = clone(flags)) == 0) {
+            shell_run(showlocks);
+        }
+    }
+    else if(!libc_strcmp(buffer, "slabinfo")) {
+        if((pid = clone(flags)) == 0) {
+            shell_run(slabinfo);
+        }
+    }
     return pid;
 }
 
@@ -193,19 +230,25 @@ static int shell_help()
 
 static int shell_ls()
 {
+    write(STDOUT, "buddyinfo\n", 11);
     write(STDOUT, "cat\n", 5);
     write(STDOUT, "fault\n", 7);
     write(STDOUT, "hello\n", 7);
     write(STDOUT, "infinity\n", 10);
+    write(STDOUT, "lockbench\n", 11);
+    write(STDOUT, "neonbench\n", 11);
+    write(STDOUT, "schedbench\n", 12);
     write(STDOUT, "showcpus\n", 10);
+    write(STDOUT, "showlocks\n", 11);
+    write(STDOUT, "slabinfo\n", 10);
     return 0;
 }
 
 static void shell_run(int (*fn)(void))
 {
     int pid = getpid();
-    ioctl(STDIN, 0, pid);
-    ioctl(STDOUT, 0, pid);
+    ioctl(STDIN, TTY_IOCTL_SET_LEADER, pid);
+    ioctl(STDOUT, TTY_IOCTL_SET_LEADER, pid);
     exec(fn);
 }
 
@@ -48,6 +48,90 @@ int showcpus()
         statsbuf[len + 1] = '\0';
         write(STDOUT, "CPU RUNNING: ", 14);
         write(STDOUT, statsbuf, len + 2);
+        ltoa(cpuinfo.runnable, statsbuf);
+        len = libc_strlen(statsbuf);
+        statsbuf[len] = '\n';
+        statsbuf[len + 1] = '\0';
+        write(STDOUT, "CPU RUNNABLE: ", 15);
+        write(STDOUT, statsbuf, len + 2);
+        ltoa(cpuinfo.schedules, statsbuf);
+        len = libc_strlen(statsbuf);
+        statsbuf[len] = '\n';
+        statsbuf[len + 1] = '\0';
+        write(STDOUT, "CPU SCHEDULES: ", 16);
+        write(STDOUT, statsbuf, len + 2);
+        ltoa(cpuinfo.schedule_time, statsbuf);
+        len = libc_strlen(statsbuf);
+        statsbuf[len] = '\n';
+        statsbuf[len + 1] = '\0';
+        write(STDOUT, "CPU SCHEDULE TICKS: ", 21);
+        write(STDOUT, statsbuf, len + 2);
+        ltoa(cpuinfo.pulls, statsbuf);
+        len = libc_strlen(statsbuf);
+        statsbuf[len] = '\n';
+        statsbuf[len + 1] = '\0';
+        write(STDOUT, "CPU PULLS: ", 12);
+        write(STDOUT, statsbuf, len + 2);
+        ltoa(cpuinfo.pull_failures, statsbuf);
+        len = libc_strlen(statsbuf);
+        statsbuf[len] = '\n';
+        statsbuf[len + 1] = '\0';
+        write(STDOUT, "CPU PULL FAILURES: ", 20);
+        write(STDOUT, statsbuf, len + 2);
+        ltoa(cpuinfo.pull_hot, statsbuf);
+        len = libc_strlen(statsbuf);
+        statsbuf[len] = '\n';
+        statsbuf[len + 1] = '\0';
+        write(STDOUT, "CPU PULL CACHE HOT: ", 21);
+        write(STDOUT, statsbuf, len + 2);
+        ltoa(cpuinfo.load_avg, statsbuf);
+        len = libc_strlen(statsbuf);
+        statsbuf[len] = '\n';
+        statsbuf[len + 1] = '\0';
+        write(STDOUT, "CPU LOAD AVERAGE (x100): ", 26);
+        write(STDOUT, statsbuf, len + 2);
+        ltoa(cpuinfo.balance_pulls, statsbuf);
+        len = libc_strlen(statsbuf);
+        statsbuf[len] = '\n';
+        statsbuf[len + 1] = '\0';
+        write(STDOUT, "CPU BALANCE PULLS: ", 20);
+        write(STDOUT, statsbuf, len + 2);
+        ltoa(cpuinfo.ticks, statsbuf);
+        len = libc_strlen(statsbuf);
+        statsbuf[len] = '\n';
+        statsbuf[len + 1] = '\0';
+        write(STDOUT, "CPU TICKS: ", 12);
+        write(STDOUT, statsbuf, len + 2);
+        ltoa(cpuinfo.wakeups, statsbuf);
+        len = libc_strlen(statsbuf);
+        statsbuf[len] = '\n';
+        statsbuf[len + 1] = '\0';
+        write(STDOUT, "CPU IDLE WAKEUPS: ", 19);
+        write(STDOUT, statsbuf, len + 2);
+        ltoa(cpuinfo.nohz_skipped, statsbuf);
+        len = libc_strlen(statsbuf);
+        statsbuf[len] = '\n';
+        statsbuf[len + 1] = '\0';
+        write(STDOUT, "CPU TICKS SKIPPED IDLE: ", 25);
+        write(STDOUT, statsbuf, len + 2);
+        ltoa(cpuinfo.wakeup_preempts, statsbuf);
+        len = libc_strlen(statsbuf);
+        statsbuf[len] = '\n';
+        statsbuf[len + 1] = '\0';
+        write(STDOUT, "CPU WAKEUP PREEMPTIONS: ", 25);
+        write(STDOUT, statsbuf, len + 2);
+        ltoa(cpuinfo.resched_ipis, statsbuf);
+        len = libc_strlen(statsbuf);
+        statsbuf[len] = '\n';
+        statsbuf[len + 1] = '\0';
+        write(STDOUT, "CPU RESCHEDULE IPIS: ", 22);
+        write(STDOUT, statsbuf, len + 2);
+        ltoa(cpuinfo.isolated, statsbuf);
+        len = libc_strlen(statsbuf);
+        statsbuf[len] = '\n';
+        statsbuf[len + 1] = '\0';
+        write(STDOUT, "CPU ISOLATED: ", 15);
+        write(STDOUT, statsbuf, len + 2);
         cpu++;
     }
     exit(0);
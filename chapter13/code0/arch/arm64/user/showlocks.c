@@ -0,0 +1,83 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "user/lockstat.h"
+
+#define STDOUT  (1)
+
+unsigned long libc_strlen(const char *s);
+void exit(int code);
+int lockstat(unsigned long index, struct user_lockstat *lockstat);
+void write(int fd, char *buffer, unsigned long count);
+
+static void ltoa(unsigned long l, char *a);
+static void print_stat(char *label, unsigned long value);
+
+int showlocks()
+{
+    unsigned long index;
+    struct user_lockstat stat;
+    index = 0;
+    while(lockstat(index, &stat)) {
+        if(!index) {
+            write(STDOUT, "LOCK STATISTICS PER ACQUISITION SITE\n", 38);
+        }
+        write(STDOUT, "\nLOCK: ", 8);
+        write(STDOUT, stat.class, libc_strlen(stat.class));
+        write(STDOUT, "\nSITE: ", 8);
+        write(STDOUT, stat.function, libc_strlen(stat.function));
+        write(STDOUT, "\n", 2);
+        print_stat("LINE: ", stat.line);
+        print_stat("ACQUISITIONS: ", stat.acquisitions);
+        print_stat("CONTENDED: ", stat.contended);
+        print_stat("WAIT TOTAL: ", stat.wait_total);
+        print_stat("WAIT MAX: ", stat.wait_max);
+        print_stat("HOLD TOTAL: ", stat.hold_total);
+        print_stat("HOLD MAX: ", stat.hold_max);
+        index++;
+    }
+    if(!index) {
+        write(STDOUT, "NO LOCK STATISTICS (BUILD WITH LOCKSTAT=1)\n", 44);
+    }
+    exit(0);
+    return 0;
+}
+
+static void ltoa(unsigned long l, char *a)
+{
+    int temp_size = 0;
+    char c, temp[20];
+    do {
+        c = l % 10;
+        c = c + 0x30;
+        temp[temp_size++] = c;
+        l /= 10;
+    } while(l);
+    while(temp_size--) {
+        *(a++) = temp[temp_size];
+    }
+    *(a++) = '\0';
+}
+
+static void print_stat(char *label, unsigned long value)
+{
+    unsigned long len;
+    char statsbuf[64];
+    ltoa(value, statsbuf);
+    len = libc_strlen(statsbuf);
+    statsbuf[len] = '\n';
+    statsbuf[len + 1] = '\0';
+    write(STDOUT, label, libc_strlen(label) + 1);
+    write(STDOUT, statsbuf, len + 2);
+}
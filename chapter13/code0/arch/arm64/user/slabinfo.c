@@ -0,0 +1,81 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "user/memory.h"
+
+#define STDOUT  (1)
+
+unsigned long libc_strlen(const char *s);
+void exit(int code);
+int memstat(unsigned long kind, unsigned long index, void *info);
+void write(int fd, char *buffer, unsigned long count);
+
+static void ltoa(unsigned long l, char *a);
+static void print_stat(char *label, unsigned long value);
+
+int slabinfo()
+{
+    unsigned long index, len;
+    struct user_slabinfo slabinfo;
+    index = 0;
+    while(memstat(MEMSTAT_SLAB, index, &slabinfo)) {
+        len = libc_strlen(slabinfo.name);
+        write(STDOUT, "\nCACHE: ", 9);
+        write(STDOUT, slabinfo.name, len);
+        write(STDOUT, "\n", 2);
+        print_stat("OBJECT SIZE: ", slabinfo.objsize);
+        print_stat("OBJECTS PER SLAB: ", slabinfo.batchsize);
+        print_stat("SLAB ORDER: ", slabinfo.pageorder);
+        print_stat("CAPACITY: ", slabinfo.capacity);
+        print_stat("FREE: ", slabinfo.freecount);
+        print_stat("ALLOCS: ", slabinfo.allocs);
+        print_stat("FREES: ", slabinfo.frees);
+        print_stat("CPUCACHE HITS: ", slabinfo.hits);
+        print_stat("CPUCACHE MISSES: ", slabinfo.misses);
+        print_stat("SLAB GROWS: ", slabinfo.grows);
+        print_stat("SLAB SHRINKS: ", slabinfo.shrinks);
+        print_stat("LOCK WAIT: ", slabinfo.lock_wait);
+        index++;
+    }
+    exit(0);
+    return 0;
+}
+
+static void ltoa(unsigned long l, char *a)
+{
+    int temp_size = 0;
+    char c, temp[20];
+    do {
+        c = l % 10;
+        c = c + 0x30;
+        temp[temp_size++] = c;
+        l /= 10;
+    } while(l);
+    while(temp_size--) {
+        *(a++) = temp[temp_size];
+    }
+    *(a++) = '\0';
+}
+
+static void print_stat(char *label, unsigned long value)
+{
+    unsigned long len;
+    char statsbuf[64];
+    ltoa(value, statsbuf);
+    len = libc_strlen(statsbuf);
+    statsbuf[len] = '\n';
+    statsbuf[len + 1] = '\0';
+    write(STDOUT, label, libc_strlen(label) + 1);
+    write(STDOUT, statsbuf, len + 2);
+}
@@ -44,6 +44,8 @@
 #define FLUSH_BITMAP_SIZE   BITMAP_SIZE(NUM_CPUS)
 
 #define TLBI_ASID(x)    ((x & 0xFFFF) << 48)
+#define FREE_BATCH_SIZE (32)
+#define MAX_NEW_TABLES  (3)
 #define USER_EXEC(vm)   (!(((vm)->prot) & PTE_UXN))
 
 extern struct memmap idle_memmap;
@@ -53,7 +55,13 @@ extern void __memmap_switch(unsigned long pgd, unsigned long asid);
 extern void __tlbi_aside1is(unsigned long asid);
 extern void __tlbi_vmalle1();
 extern struct virtualmem *alloc_virtualmem();
+extern void memcpy(void *to, void *from, unsigned long count);
 
+static int expand_stack(unsigned long addr, struct memmap *mm);
+static struct virtualmem *find_virtualmem(unsigned long addr, struct memmap *mm);
+static int grow_stack(unsigned long addr, struct virtualmem **vm);
+static unsigned long *install_page_table(unsigned long *entry, struct page **ptables,
+    unsigned int *next_table);
 static unsigned long new_asid_context(struct memmap *new);
 
 static unsigned long active_asids[NUM_CPUS];
@@ -85,6 +93,50 @@ static inline int freeable_page_table(int index, int end, struct memmap *mm,
     );
 }
 
+static inline void queue_free_page(struct page **batch, unsigned int *count,
+    struct page *page)
+{
+    batch[(*count)++] = page;
+    if(*count == FREE_BATCH_SIZE) {
+        free_pages_bulk(batch, *count);
+        *count = 0;
+    }
+}
+
+static unsigned int missing_page_tables(unsigned long addr, unsigned long *pgd)
+{
+    unsigned long *table;
+    unsigned long phys_addr;
+    unsigned int shifts[MAX_NEW_TABLES] = {PGD_SHIFT, PUD_SHIFT, PMD_SHIFT};
+    table = pgd;
+    for(unsigned int i = 0; i < MAX_NEW_TABLES; i++) {
+        phys_addr = *(table + ((addr >> shifts[i]) & (TABLE_INDEX_MASK)));
+        phys_addr &= (RAW_PAGE_TABLE_ADDR_MASK);
+        if(!phys_addr) {
+            return MAX_NEW_TABLES - i;
+        }
+        table = (unsigned long *) PHYS_TO_VIRT(phys_addr);
+    }
+    return 0;
+}
+
+static unsigned long *find_user_pte(unsigned long addr, unsigned long *pgd)
+{
+    unsigned long *table;
+    unsigned long phys_addr;
+    unsigned int shifts[MAX_NEW_TABLES] = {PGD_SHIFT, PUD_SHIFT, PMD_SHIFT};
+    table = pgd;
+    for(unsigned int i = 0; i < MAX_NEW_TABLES; i++) {
+        phys_addr = *(table + ((addr >> shifts[i]) & (TABLE_INDEX_MASK)));
+        phys_addr &= (RAW_PAGE_TABLE_ADDR_MASK);
+        if(!phys_addr) {
+            return 0;
+        }
+        table = (unsigned long *) PHYS_TO_VIRT(phys_addr);
+    }
+    return table + ((addr >> PAGE_SHIFT) & (TABLE_INDEX_MASK));
+}
+
 static int check_update_reserved_asid(unsigned long asid, unsigned long newasid)
 {
     int hit = 0;
@@ -120,7 +172,9 @@ void free_user_memmap(struct memmap *mm)
     unsigned long pud_phys_addr, *pud_virt_addr, pud_raw_entry;
     unsigned long pmd_phys_addr, *pmd_virt_addr, pmd_raw_entry;
     unsigned long pte_phys_addr, *pte_virt_addr;
+    unsigned int count = 0;
     struct page *page, *pgtable;
+    struct page *batch[FREE_BATCH_SIZE];
     struct virtualmem *vm, *next;
     unsigned long *pgd = mm->pgd;
     LIST_FOR_EACH_ENTRY_SAFE(vm, next, &(mm->vmems), vmlist) {
@@ -157,29 +211,31 @@ void free_user_memmap(struct memmap *mm)
                     if(freeable_page_table(m, m_end, mm, next, PMD_SHIFT)) {
                         DMB(ishst);
                         pgtable = &(PTR_TO_PAGE(pte_virt_addr));
-                        free_pages(pgtable);
+                        queue_free_page(batch, &count, pgtable);
                         DSB(ishst);
                     }
                 }
                 if(freeable_page_table(u, u_end, mm, next, PUD_SHIFT)) {
                     DMB(ishst);
                     pgtable = &(PTR_TO_PAGE(pmd_virt_addr));
-                    free_pages(pgtable);
+                    queue_free_page(batch, &count, pgtable);
                     DSB(ishst);
                 }
             }
             if(freeable_page_table(g, g_end, mm, next, PGD_SHIFT)) {
                 DMB(ishst);
                 pgtable = &(PTR_TO_PAGE(pud_virt_addr));
-                free_pages(pgtable);
+                queue_free_page(batch, &count, pgtable);
                 DSB(ishst);
             }
         }
-        free_pages(page);
+        page_remove_mapping(page, vm);
+        queue_free_page(batch, &count, page);
         list_delete(&(vm->vmlist));
         cake_free(vm);
     }
     __tlbi_aside1is(TLBI_ASID(mm->context.id));
+    free_pages_bulk(batch, count);
 }
 
 void init_mem_context(struct memmap *new)
@@ -210,6 +266,52 @@ void memmap_switch(struct memmap *old, struct memmap *new, struct process *p)
     }
 }
 
+int migrate_user_pages(struct virtualmem *vm, struct page *page, struct page *new)
+{
+    unsigned long addr, flags, index, mapping_addr, *pte;
+    unsigned long mapped[BITMAP_SIZE((1 << MAX_ORDER))];
+    struct memmap *mm = vm->mm;
+    unsigned long numpages = (vm->vm_end - vm->vm_start) >> PAGE_SHIFT;
+    if(numpages > (1 << page->current_order)) {
+        goto failure;
+    }
+    if(!WRITE_TRYLOCK_IRQSAVE(&(mm->lock), &flags)) {
+        goto failure;
+    }
+    if(vm->page != page || READ_ONCE(page->refcount) != 1) {
+        goto unlock;
+    }
+    bitmap_zero(mapped, numpages);
+    for(index = 0; index < numpages; index++) {
+        pte = find_user_pte(vm->vm_start + (index << PAGE_SHIFT), mm->pgd);
+        if(pte && *pte) {
+            set_bit(mapped, index);
+            WRITE_ONCE(*pte, 0);
+        }
+    }
+    __tlbi_aside1is(TLBI_ASID(mm->context.id));
+    memcpy(PAGE_TO_PTR(new), PAGE_TO_PTR(page), (PAGE_SIZE << page->current_order));
+    if(USER_EXEC(vm)) {
+        __flush_icache_range(PAGE_TO_PTR(new), (PAGE_SIZE << page->current_order));
+    }
+    mapping_addr = VIRT_TO_PHYS((unsigned long) PAGE_TO_PTR(new));
+    for(index = 0; index < numpages; index++) {
+        if(test_bit(mapped, index)) {
+            addr = vm->vm_start + (index << PAGE_SHIFT);
+            pte = find_user_pte(addr, mm->pgd);
+            WRITE_ONCE(*pte, (mapping_addr + (addr - vm->vm_start)) | vm->prot);
+        }
+    }
+    DSB(ishst);
+    vm->page = new;
+    WRITE_UNLOCK_IRQRESTORE(&(mm->lock), flags);
+    return 0;
+unlock:
+    WRITE_UNLOCK_IRQRESTORE(&(mm->lock), flags);
+failure:
+    return 1;
+}
+
 static unsigned long new_asid_context(struct memmap *new)
 {
     static unsigned int index = 1;
@@ -235,6 +337,33 @@ static unsigned long new_asid_context(struct memmap *new)
     return IDX2ASID(asid) | generation;
 }
 
+static int expand_stack(unsigned long addr, struct memmap *mm)
+{
+    int err = 0;
+    struct virtualmem *vm;
+    WRITE_LOCK(&(mm->lock));
+    vm = find_virtualmem(addr, mm);
+    if(!vm) {
+        err = 1;
+    }
+    else if(addr < vm->vm_start) {
+        err = grow_stack(addr, &vm);
+    }
+    WRITE_UNLOCK(&(mm->lock));
+    return err;
+}
+
+static struct virtualmem *find_virtualmem(unsigned long addr, struct memmap *mm)
+{
+    struct virtualmem *vm;
+    LIST_FOR_EACH_ENTRY(vm, &(mm->vmems), vmlist) {
+        if(vm->vm_end > addr) {
+            return vm;
+        }
+    }
+    return 0;
+}
+
 static int grow_stack(unsigned long addr, struct virtualmem **vm)
 {
     struct list *insert;
@@ -248,11 +377,10 @@ static int grow_stack(unsigned long addr, struct virtualmem **vm)
         if(!new) {
             goto failure;
         }
-        page = alloc_pages(STACK_SHIFT);
+        page = alloc_pages_movable_zeroed(STACK_SHIFT);
         if(!page) {
             goto freevirtualmem;
         }
-        memset(PAGE_TO_PTR(page), 0, STACK_SIZE);
         new->vm_end = check->vm_end - STACK_SIZE;
         new->vm_start = new->vm_end - STACK_SIZE;
         new->mm = check->mm;
@@ -261,6 +389,7 @@ static int grow_stack(unsigned long addr, struct virtualmem **vm)
         new->page = page;
         insert = check->vmlist.prev;
         list_add(insert, &(new->vmlist));
+        page_add_mapping(page, new);
         *vm = new;
         return 0;
     }
@@ -271,97 +400,89 @@ failure:
     return 1;
 }
 
+static unsigned long *install_page_table(unsigned long *entry, struct page **ptables,
+    unsigned int *next_table)
+{
+    unsigned long old, phys_addr;
+    unsigned long *table = (unsigned long *) PFN_TO_PTR((ptables[*next_table]->pfn));
+    phys_addr = VIRT_TO_PHYS((unsigned long) table);
+    DMB(ishst);
+    old = CMPXCHG_RELAXED(entry, 0, phys_addr | PAGE_TABLE_TABLE);
+    if(old) {
+        return (unsigned long *) PHYS_TO_VIRT(old & (RAW_PAGE_TABLE_ADDR_MASK));
+    }
+    DSB(ishst);
+    (*next_table)++;
+    return table;
+}
+
 int populate_page_tables(unsigned long addr, struct memmap *mm)
 {
     unsigned int pgd_index, pud_index, pmd_index, pte_index;
-    unsigned long pgd_raw_entry;
-    unsigned long pud_phys_addr, *pud_virt_addr, pud_raw_entry;
-    unsigned long pmd_phys_addr, *pmd_virt_addr, pmd_raw_entry;
+    unsigned long pud_phys_addr, *pud_virt_addr;
+    unsigned long pmd_phys_addr, *pmd_virt_addr;
     unsigned long pte_phys_addr, *pte_virt_addr, *pte_target, mapping_addr;
-    unsigned long flags;
     unsigned long *pgd = mm->pgd;
-    struct virtualmem *vm = 0;
-    struct page *page, *ptable;
-    flags = SPIN_LOCK_IRQSAVE(&(mm->lock));
-    LIST_FOR_EACH_ENTRY(vm, &(mm->vmems), vmlist) {
-        if(vm->vm_end > addr) {
-            break;
-        }
-    }
+    unsigned int num_tables, next_table = 0;
+    struct virtualmem *vm;
+    struct page *page;
+    struct page *ptables[MAX_NEW_TABLES];
+retry:
+    READ_LOCK(&(mm->lock));
+    vm = find_virtualmem(addr, mm);
     if(!vm) {
-        goto failure;
+        goto unlock;
     }
-    if(addr < vm->vm_start && grow_stack(addr, &vm)) {
-        goto failure;
+    if(addr < vm->vm_start) {
+        READ_UNLOCK(&(mm->lock));
+        if(expand_stack(addr, mm)) {
+            goto failure;
+        }
+        goto retry;
     }
     page = vm->page;
+    num_tables = missing_page_tables(addr, pgd);
+    if(num_tables && !alloc_pages_bulk_zeroed(0, num_tables, ptables)) {
+        goto unlock;
+    }
     pgd_index = (addr >> PGD_SHIFT) & (TABLE_INDEX_MASK);
-    pgd_raw_entry = *(pgd + pgd_index);
-    pud_phys_addr = pgd_raw_entry & (RAW_PAGE_TABLE_ADDR_MASK);
+    pud_phys_addr = READ_ONCE(*(pgd + pgd_index)) & (RAW_PAGE_TABLE_ADDR_MASK);
     pud_virt_addr = (unsigned long *) PHYS_TO_VIRT(pud_phys_addr);
     if(!pud_phys_addr) {
-        DMB(ishst);
-        ptable = alloc_pages(0);
-        if(!ptable) {
-            goto unlock;
-        }
-        pud_virt_addr = (unsigned long *) PFN_TO_PTR((ptable->pfn));
-        memset(pud_virt_addr, 0, PAGE_SIZE);
-        pud_phys_addr = VIRT_TO_PHYS((unsigned long) pud_virt_addr);
-        WRITE_ONCE(*(pgd + pgd_index), pud_phys_addr | PAGE_TABLE_TABLE);
-        DSB(ishst);
+        pud_virt_addr = install_page_table(pgd + pgd_index, ptables, &next_table);
     }
     pud_index = (addr >> PUD_SHIFT) & (TABLE_INDEX_MASK);
-    pud_raw_entry = *(pud_virt_addr + pud_index);
-    pmd_phys_addr = pud_raw_entry & (RAW_PAGE_TABLE_ADDR_MASK);
+    pmd_phys_addr = READ_ONCE(*(pud_virt_addr + pud_index)) & (RAW_PAGE_TABLE_ADDR_MASK);
     pmd_virt_addr = (unsigned long *) PHYS_TO_VIRT(pmd_phys_addr);
     if(!pmd_phys_addr) {
-        DMB(ishst);
-        ptable = alloc_pages(0);
-        if(!ptable) {
-            goto unlock;
-        }
-        pmd_virt_addr = (unsigned long *) PFN_TO_PTR((ptable->pfn));
-        memset(pmd_virt_addr, 0, PAGE_SIZE);
-        pmd_phys_addr = VIRT_TO_PHYS((unsigned long) pmd_virt_addr);
-        WRITE_ONCE(*(pud_virt_addr + pud_index), pmd_phys_addr | PAGE_TABLE_TABLE);
-        DSB(ishst);
+        pmd_virt_addr = install_page_table(pud_virt_addr + pud_index, ptables, &next_table);
     }
     pmd_index = (addr >> PMD_SHIFT) & (TABLE_INDEX_MASK);
-    pmd_raw_entry = *(pmd_virt_addr + pmd_index);
-    pte_phys_addr = pmd_raw_entry & (RAW_PAGE_TABLE_ADDR_MASK);
+    pte_phys_addr = READ_ONCE(*(pmd_virt_addr + pmd_index)) & (RAW_PAGE_TABLE_ADDR_MASK);
     pte_virt_addr = (unsigned long *) PHYS_TO_VIRT(pte_phys_addr);
     if(!pte_phys_addr) {
-        DMB(ishst);
-        ptable = alloc_pages(0);
-        if(!ptable) {
-            goto unlock;
-        }
-        pte_virt_addr = (unsigned long *) PFN_TO_PTR((ptable->pfn));
-        memset(pte_virt_addr, 0, PAGE_SIZE);
-        pte_phys_addr = VIRT_TO_PHYS((unsigned long) pte_virt_addr);
-        WRITE_ONCE(*(pmd_virt_addr + pmd_index), pte_phys_addr | PAGE_TABLE_TABLE);
-        DSB(ishst);
+        pte_virt_addr = install_page_table(pmd_virt_addr + pmd_index, ptables, &next_table);
     }
     pte_index = (addr >> PAGE_SHIFT) & (TABLE_INDEX_MASK);
     pte_target = pte_virt_addr + pte_index;
-    if(!(*pte_target)) {
+    if(!READ_ONCE(*pte_target)) {
         DMB(ishst);
         mapping_addr = VIRT_TO_PHYS((unsigned long) PAGE_TO_PTR(page));
         mapping_addr += (addr - vm->vm_start);
         mapping_addr &= PAGE_MASK;
-        WRITE_ONCE(*pte_target, mapping_addr | vm->prot);
+        CMPXCHG_RELAXED(pte_target, 0, mapping_addr | vm->prot);
         DSB(ishst);
     }
-    PREEMPT_DISABLE();
-    SPIN_UNLOCK_IRQRESTORE(&(mm->lock), flags);
+    if(next_table < num_tables) {
+        free_pages_bulk(ptables + next_table, num_tables - next_table);
+    }
     if(USER_EXEC(vm)) {
         __flush_icache_range(PAGE_TO_PTR(page), (PAGE_SIZE << page->current_order));
     }
-    PREEMPT_ENABLE();
+    READ_UNLOCK(&(mm->lock));
     return 0;
 unlock:
-    SPIN_UNLOCK_IRQRESTORE(&(mm->lock), flags);
+    READ_UNLOCK(&(mm->lock));
 failure:
     return !(0);
 }
@@ -16,35 +16,53 @@
 #define _CAKE_ALLOCATE_H
 
 #include "config/config.h"
+#include "cake/cake.h"
 #include "cake/list.h"
 #include "cake/lock.h"
 #include "arch/page.h"
 
 #define MAX_ORDER                       (9)
+#define CONTIG_REGION_SHIFT             (24)
+#define CONTIG_REGION_SIZE              (1UL << (CONTIG_REGION_SHIFT))
+#define CONTIG_REGION_PAGES             ((CONTIG_REGION_SIZE) >> (PAGE_SHIFT))
+#define MIGRATE_UNMOVABLE               (0)
+#define MIGRATE_MOVABLE                 (1)
+#define MIGRATE_TYPES                   (2)
 #define MIN_SIZE_CACHE_ORDER            (5)
 #define CPUCACHE_FILL_SIZE              (15)
 #define CPUCACHE_CAPACITY               (31)
 #define DEFAULT_SIZE_CACHE_BATCHSIZE    (64)
 #define NUM_SIZE_CACHES                 (16)
 #define ONSLAB_DESCRIPTOR_SIZE          (512)
+#define PAGECACHE_MAX_ORDER             (3)
+#define PAGECACHE_BATCH(order)          ((16) >> (order))
+#define PAGECACHE_HIGH(order)           ((PAGECACHE_BATCH(order)) << 1)
+#define SLABSFREE_RESERVE               (1)
+#define ZEROPOOL_MAX_ORDER              (3)
+#define ZEROPOOL_TARGET(order)          ((32) >> (order))
 
 #define GLOBAL_MEMMAP                   system_phys_page_dir
 #define PAGE_TO_PTR(page)               PFN_TO_PTR((page->pfn))
 #define PTR_TO_PAGE(ptr)                GLOBAL_MEMMAP[PTR_TO_PFN((ptr))]
 
+struct virtualmem;
+
 struct page {
     unsigned long allocated: 1;
     unsigned long reserved: 1;
     unsigned long valid: 1;
+    unsigned long movable: 1;
+    unsigned long migratetype: 1;
     unsigned long current_order: 4;
     unsigned long original_order: 4;
-    unsigned long pfn: 53;
+    unsigned long pfn: 51;
     union {
         struct list pagelist;
         struct {
             struct slab *slab;
             struct cache *cache;
         };
+        struct virtualmem *mapping;
 
     };
     unsigned long refcount;
@@ -64,6 +82,40 @@ struct cpucache {
     unsigned int capacity;
 };
 
+struct pagecache {
+    unsigned int count[PAGECACHE_MAX_ORDER + 1];
+    struct list pagelists[PAGECACHE_MAX_ORDER + 1];
+    unsigned long refills;
+    unsigned long drains;
+};
+
+struct zeropool {
+    unsigned int count[ZEROPOOL_MAX_ORDER + 1];
+    struct list pagelists[ZEROPOOL_MAX_ORDER + 1];
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long refills;
+    struct spinlock lock;
+};
+
+struct contigregion {
+    unsigned long startpfn;
+    unsigned long numpages;
+    unsigned long freepages;
+    unsigned long allocs;
+    unsigned long failures;
+    unsigned long bitmap[BITMAP_SIZE(CONTIG_REGION_PAGES)];
+    unsigned long ends[BITMAP_SIZE(CONTIG_REGION_PAGES)];
+    struct spinlock lock;
+};
+
+struct cachestat {
+    unsigned long allocs;
+    unsigned long frees;
+    unsigned long hits;
+    unsigned long misses;
+};
+
 struct cache {
     char name[32];
     struct list cachelist;
@@ -72,8 +124,16 @@ struct cache {
     unsigned int freecount;
     unsigned int capacity;
     unsigned int pageorder;
+    unsigned int colour_next;
+    void (*ctor)(void *obj);
+    void (*dtor)(void *obj);
     struct spinlock lock;
     struct cpucache *cpucaches[NUM_CPUS];
+    unsigned char touched[NUM_CPUS];
+    struct cachestat stats[NUM_CPUS];
+    unsigned long grows;
+    unsigned long shrinks;
+    unsigned long lock_wait;
     struct list slabsfull;
     struct list slabspart;
     struct list slabsfree;
@@ -82,10 +142,23 @@ struct cache {
 extern struct page *system_phys_page_dir;
 
 struct cache *alloc_cache(char *name, unsigned long objsize);
+struct cache *alloc_cache_ctor(char *name, unsigned long objsize,
+    void (*ctor)(void *obj), void (*dtor)(void *obj));
+struct page *alloc_contig_pages(unsigned long numpages);
 void *alloc_obj(struct cache *cache);
 struct page *alloc_pages(unsigned int order);
+unsigned int alloc_pages_bulk(unsigned int order, unsigned int n, struct page **pages);
+unsigned int alloc_pages_bulk_movable(unsigned int order, unsigned int n, struct page **pages);
+unsigned int alloc_pages_bulk_zeroed(unsigned int order, unsigned int n, struct page **pages);
+struct page *alloc_pages_movable(unsigned int order);
+struct page *alloc_pages_movable_zeroed(unsigned int order);
+struct page *alloc_pages_zeroed(unsigned int order);
 void *cake_alloc(unsigned long size);
 void cake_free(void *obj);
+void drain_idle_cpucaches();
 void free_pages(struct page *page);
+void free_pages_bulk(struct page **pages, unsigned int n);
+void refill_zeroed_pages();
+unsigned long shrink_caches();
 
 #endif
@@ -15,9 +15,21 @@
 #ifndef _CAKE_LOCK_H
 #define _CAKE_LOCK_H
 
+#include "config/config.h"
+
+struct lockstat;
+
+struct rwlock {
+    unsigned int count;
+};
+
 struct spinlock {
     unsigned int owner;
     unsigned int ticket;
+#if LOCKSTAT
+    unsigned long acquired;
+    struct lockstat *site;
+#endif
 };
 
 #endif
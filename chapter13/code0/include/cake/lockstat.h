@@ -0,0 +1,47 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CAKE_LOCKSTAT_H
+#define _CAKE_LOCKSTAT_H
+
+#include "cake/lock.h"
+
+#define LOCKSTAT_SITE(lock) ({                      \
+    static struct lockstat __lockstat = {           \
+        .class = #lock,                             \
+        .function = __func__,                       \
+        .line = __LINE__                            \
+    };                                              \
+    &__lockstat;                                    \
+})
+
+struct lockstat {
+    const char *class;
+    const char *function;
+    unsigned long line;
+    unsigned long registered;
+    unsigned long acquisitions;
+    unsigned long contended;
+    unsigned long wait_total;
+    unsigned long wait_max;
+    unsigned long hold_total;
+    unsigned long hold_max;
+    struct lockstat *next;
+};
+
+void lockstat_acquire(struct spinlock *lock, struct lockstat *site, int contended,
+    unsigned long wait);
+void lockstat_release(struct spinlock *lock);
+
+#endif
@@ -20,6 +20,7 @@
 #include "cake/file.h"
 #include "cake/list.h"
 #include "cake/lock.h"
+#include "cake/rbtree.h"
 #include "arch/process.h"
 
 #define CPUMASK_SIZE                        BITMAP_SIZE(NUM_CPUS)
@@ -27,15 +28,23 @@
 #define PROCESS_STATE_INTERRUPTIBLE         0b00000001
 #define PROCESS_STATE_STOPPED               0b00000010
 #define PROCESS_STATE_EXIT                  0b00000100
+#define PROCESS_STATE_UNINTERRUPTIBLE       0b00001000
 
 struct process {
     unsigned int state;
     unsigned int pid;
     unsigned int priority;
+    unsigned int policy;
+    unsigned int rt_priority;
     int tick_countdown;
     unsigned int exitcode;
     unsigned int flags;
     unsigned long runtime_counter;
+    unsigned long vruntime;
+    unsigned long last_ran;
+    unsigned int cpu;
+    unsigned int queued;
+    unsigned int need_resched;
     unsigned long refcount;
     unsigned long *stack;
     long preempt_count;
@@ -43,7 +52,8 @@ struct process {
     struct memmap *active_memmap;
     struct signal *signal;
     struct folder folder;
-    struct list processlist;
+    struct rbnode runnode;
+    struct list rtlist;
     struct list childlist;
     struct list siblinglist;
     struct process *parent;
@@ -0,0 +1,45 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CAKE_RBTREE_H
+#define _CAKE_RBTREE_H
+
+#include "cake/cake.h"
+
+#define RB_RED      (0)
+#define RB_BLACK    (1)
+
+#define RB_ENTRY(ptr, type, member)     \
+    CONTAINER_OF(ptr, type, member)
+
+#define RB_FIRST(tree)  ((tree)->leftmost)
+
+struct rbnode {
+    struct rbnode *parent;
+    struct rbnode *left;
+    struct rbnode *right;
+    unsigned long colour;
+};
+
+struct rbtree {
+    struct rbnode *root;
+    struct rbnode *leftmost;
+};
+
+void rb_erase(struct rbtree *tree, struct rbnode *node);
+void rb_insert(struct rbtree *tree, struct rbnode *node,
+    int (*less)(struct rbnode *a, struct rbnode *b));
+struct rbnode *rb_next(struct rbnode *node);
+
+#endif
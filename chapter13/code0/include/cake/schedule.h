@@ -19,7 +19,9 @@
 #include "cake/list.h"
 #include "cake/lock.h"
 #include "cake/process.h"
+#include "cake/rbtree.h"
 #include "arch/schedule.h"
+#include "user/sched.h"
 
 #define PREEMPT_DISABLE()       do { \
                                         CURRENT->preempt_count++; \
@@ -27,21 +29,54 @@
                                 } while(0)
 #define PREEMPT_ENABLE()        do { \
                                     BARRIER(); \
-                                    CURRENT->preempt_count--; \
+                                    if(!--CURRENT->preempt_count && \
+                                        READ_ONCE(CURRENT->need_resched)) { \
+                                        preempt_schedule(); \
+                                    } \
                                 } while(0)
+#define PROCESS_RT(p)           ((p)->policy != SCHED_NORMAL)
+#define RT_QUEUE(p)             (SCHED_RT_PRIORITY_MAX - (p)->rt_priority)
+#define RT_QUEUES               (SCHED_RT_PRIORITY_MAX + 1)
 #define SET_CURRENT_STATE(v)    WRITE_ONCE(CURRENT->state, v)
 
 struct runqueue {
     unsigned int switch_count;
     unsigned int weight;
-    struct list queue;
+    unsigned int nr_running;
+    unsigned int nr_rt;
+    unsigned long schedule_count;
+    unsigned long schedule_time;
+    unsigned long next_balance;
+    unsigned long queued_weight;
+    unsigned long load_avg;
+    unsigned long balance_countdown;
+    unsigned long balance_pulls;
+    unsigned long nohz;
+    unsigned long nohz_stopped;
+    unsigned long tick_stopped;
+    unsigned long nohz_tick;
+    unsigned long nohz_received;
+    unsigned long nohz_skipped;
+    unsigned long ticks;
+    unsigned long wakeups;
+    unsigned long wakeup_preempts;
+    unsigned long resched_ipis;
+    unsigned long pulls;
+    unsigned long pull_failures;
+    unsigned long pull_hot;
+    struct rbtree timeline;
+    unsigned long rtmask[BITMAP_SIZE(RT_QUEUES)];
+    struct list rtqueues[RT_QUEUES];
     struct spinlock lock;
     struct process idle_task;
     struct memmap *saved_memmap;
     struct process *current;
 };
 
+void preempt_schedule();
+int process_on_cpu(struct process *p);
 void runqueue_process(struct process *process);
 void schedule_self();
+void wake_process(struct process *process);
 
 #endif
@@ -0,0 +1,30 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CAKE_SEMAPHORE_H
+#define _CAKE_SEMAPHORE_H
+
+#include "cake/wait.h"
+
+struct semaphore {
+    unsigned long count;
+    struct waitqueue waitqueue;
+};
+
+void semaphore_down(struct semaphore *semaphore);
+int semaphore_down_trylock(struct semaphore *semaphore);
+void semaphore_init(struct semaphore *semaphore, unsigned long count);
+void semaphore_up(struct semaphore *semaphore);
+
+#endif
@@ -0,0 +1,45 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CAKE_TIMER_H
+#define _CAKE_TIMER_H
+
+#include "config/config.h"
+#include "cake/cake.h"
+#include "cake/list.h"
+
+#define TIMER_WHEEL_BITS        (6)
+#define TIMER_WHEEL_SIZE        (1 << (TIMER_WHEEL_BITS))
+#define TIMER_WHEEL_MASK        ((TIMER_WHEEL_SIZE) - 1)
+#define TIMER_WHEEL_LEVELS      (4)
+#define TIMER_WHEEL_MAX_DELTA   ((1UL << ((TIMER_WHEEL_BITS) * (TIMER_WHEEL_LEVELS))) - 1)
+#define TIMER_WHEEL_CPU         (0)
+
+#define NSECS_PER_SEC           (1000000000UL)
+#define NSECS_TO_TICKS(ns)      (DIV_ROUND_UP((ns) * (TIMER_HZ), NSECS_PER_SEC))
+#define TICKS_TO_NSECS(t)       (((t) % (TIMER_HZ)) * ((NSECS_PER_SEC) / (TIMER_HZ)))
+
+struct timer {
+    unsigned long expires;
+    void (*fn)(struct timer *self);
+    struct list timerlist;
+};
+
+void add_timer(struct timer *timer);
+int del_timer(struct timer *timer);
+void run_timers();
+long schedule_timeout(long ticks);
+unsigned long timer_ticks();
+
+#endif
@@ -16,18 +16,21 @@
 #define _CAKE_TTY_H
 
 #include "cake/file.h"
+#include "cake/mutex.h"
 #include "cake/wait.h"
 
 #define TERMIOS_NEWLINE         (0)
 #define TERMIOS_ERASE           (1)
 #define TERMIOS_INTR            (2)
 #define TERMIOS_EOF             (3)
+#define TERMIOS_TIME            (4)
 #define TERMIOS_MAX             (8)
 
 #define TTY_NEWLINE_CHAR(tty)   ((tty)->termios[TERMIOS_NEWLINE])
 #define TTY_ERASE_CHAR(tty)     ((tty)->termios[TERMIOS_ERASE])
 #define TTY_INTR_CHAR(tty)      ((tty)->termios[TERMIOS_INTR])
 #define TTY_EOF_CHAR(tty)       ((tty)->termios[TERMIOS_EOF])
+#define TTY_TIME(tty)           ((unsigned char) (tty)->termios[TERMIOS_TIME])
 
 struct tty_termios;
 
@@ -41,6 +44,7 @@ struct tty {
     unsigned int open_count;
     int pid_leader;
     struct waitqueue waitqueue;
+    struct mutex write_mutex;
 };
 
 struct tty_driver {
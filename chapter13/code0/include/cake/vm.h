@@ -15,6 +15,7 @@
 #ifndef _CAKE_VM_H
 #define _CAKE_VM_H
 
+#include "cake/allocate.h"
 #include "cake/list.h"
 #include "cake/lock.h"
 #include "arch/vm.h"
@@ -54,11 +55,13 @@ struct memmap {
     unsigned long start_stack;
     unsigned long start_heap;
     unsigned long end_heap;
-    struct spinlock lock;
+    struct rwlock lock;
     struct mem_context context;    
 };
 
 void drop_memmap(struct memmap *memmap);
+void page_add_mapping(struct page *page, struct virtualmem *vm);
+void page_remove_mapping(struct page *page, struct virtualmem *vm);
 void put_memmap(struct memmap *memmap);
 
 #endif
@@ -14,12 +14,17 @@
 
 #include "cake/allocate.h"
 #include "cake/atomic.h"
+#include "cake/bitops.h"
 #include "cake/error.h"
 #include "cake/lock.h"
 #include "cake/list.h"
+#include "cake/user.h"
+#include "arch/cache.h"
 #include "arch/lock.h"
 #include "arch/page.h"
 #include "arch/smp.h"
+#include "arch/timer.h"
+#include "user/memory.h"
 
 #define PAGE_IS_TAIL(page)      ((page->pfn) & ((1 << ((page->current_order) + 1)) - 1))
 #define PAGE_IS_HEAD(page)      (!(PAGE_IS_TAIL(page)))
@@ -33,27 +38,65 @@
     ((page->current_order) < (page->original_order))  &&    \
     ((buddy->current_order) < (buddy->original_order)))
 
+#define PAGE_IS_CONTIG(page)    (((page->pfn) - contig.startpfn) < contig.numpages)
+#define PAGEBLOCK_PAGES         (1UL << (MAX_ORDER))
+#define PAGEBLOCK(page)         (&(GLOBAL_MEMMAP[(page->pfn) & ~(PAGEBLOCK_PAGES - 1)]))
+#define PAGE_FREELIST(page, order)                          \
+    (&(freelists[PAGEBLOCK(page)->migratetype][order]))
+
 #define CPUCACHE_DATA(cache) ((void **) (((struct cpucache *) (cache)) + 1))
 #define SLAB_FREE_STACK(slab) ((unsigned int *) (((struct slab *) (slab)) + 1))
 #define OBJ_CACHE(ptr) (&(PTR_TO_PAGE(ptr)))->cache
 #define OBJ_SLAB(ptr) (&(PTR_TO_PAGE(ptr)))->slab
 
-extern void arch_populate_allocate_structures(struct list *freelists);
+extern unsigned long arch_populate_allocate_structures(struct list *freelists,
+    struct contigregion *contig);
+extern int migrate_mapped_pages(struct page *page, struct page *new);
 extern void memset(void *dest, int c, unsigned long count);
 
+static struct page *alloc_buddy_pages(unsigned int order, unsigned int migratetype);
+static struct page *alloc_buddy_pages_nofallback(unsigned int order, unsigned int migratetype);
+static struct page *alloc_compact_target(unsigned int order);
 static struct cpucache **alloc_cpucaches();
+static struct page *alloc_pagecache_pages(unsigned int order);
+static unsigned int alloc_pages_bulk_type(unsigned int order, unsigned int n,
+    struct page **pages, unsigned int migratetype);
+static struct page *alloc_pages_type(unsigned int order, unsigned int migratetype);
 static unsigned int cake_alloc_index(unsigned long size);
+static void *cake_alloc_large(unsigned long size);
+static int compact_pageblock(unsigned long startpfn);
+static int compact_pages(unsigned int order);
+static void drain_cpucache(struct cache *cache, struct cpucache *cpucache);
+static void drain_pagecache(struct pagecache *pagecache, unsigned int order, unsigned int count);
+static void free_buddy_pages(struct page *page);
+static void free_cache_slab(struct cache *cache, struct slab *slab);
+static void free_contig_pages(struct page *page);
 static void free_object_to_cache_pool();
+static void free_pagecache_pages(struct page *page);
 static long fill_cpucache();
+static void fill_pagecache(struct pagecache *pagecache, unsigned int order);
 static void *next_free_obj(struct cache *cache);
+static int memstat_buddy(struct user_buddyinfo *user);
+static int memstat_slab(unsigned long index, struct user_slabinfo *user);
+static unsigned long reclaim_pages();
+static unsigned long reclaim_slabs(unsigned int reserve, int offslab);
 static unsigned int resize_batch(unsigned long numpages, unsigned long objsize);
 static void setup_cache_cache();
 static void setup_size_caches();
+static void size_cache_name(char *name, unsigned long objsize);
+static struct page *split_buddy_pages(struct page *p, unsigned int from, unsigned int order);
+static unsigned int take_zeroed_pages(unsigned int order, unsigned int n,
+    struct page **pages);
+static unsigned int try_alloc_pages_bulk(unsigned int order, unsigned int n,
+    struct page **pages, unsigned int migratetype);
+static struct page *try_alloc_pages(unsigned int order, unsigned int migratetype);
 
 static struct spinlock allocator_lock = {
     .owner = 0,
     .ticket = 0
 };
+static unsigned long allocator_lock_acquires;
+static unsigned long allocator_lock_wait;
 static struct cache cache_cache = {
     .name = {'c', 'a', 'c', 'h', 'e', '\0'},
     .objsize = sizeof(struct cache),
@@ -81,16 +124,110 @@ static struct list cachelist = {
     .prev = &cachelist,
     .next = &cachelist
 };
-static struct list freelists[MAX_ORDER + 1];
+static struct spinlock cachelist_lock = {
+    .owner = 0,
+    .ticket = 0
+};
+static struct contigregion contig = {
+    .lock = {
+        .owner = 0,
+        .ticket = 0
+    }
+};
+static unsigned long compact_failures;
+static unsigned long compact_successes;
+static unsigned long compact_migrated;
+static struct list freelists[MIGRATE_TYPES][MAX_ORDER + 1];
+static struct pagecache pagecaches[NUM_CPUS];
+static unsigned long shrink_pending;
+static unsigned long total_pages;
 static struct cache sizecaches[NUM_SIZE_CACHES];
+static struct zeropool zeropool = {
+    .lock = {
+        .owner = 0,
+        .ticket = 0
+    }
+};
 struct page *system_phys_page_dir;
 
+static inline void lock_allocator()
+{
+    unsigned long start = TIMER_COUNT();
+    SPIN_LOCK(&allocator_lock);
+    allocator_lock_wait += TIMER_COUNT() - start;
+    allocator_lock_acquires++;
+}
+
+static inline void lock_cache(struct cache *cache)
+{
+    unsigned long start = TIMER_COUNT();
+    SPIN_LOCK(&(cache->lock));
+    cache->lock_wait += TIMER_COUNT() - start;
+}
+
+static inline void set_page_allocated(struct page *page, unsigned int order,
+    unsigned int allocated)
+{
+    for(unsigned long i = page->pfn; i < (page->pfn + (1 << order)); i++) {
+        GLOBAL_MEMMAP[i].allocated = allocated;
+    }
+}
+
 static inline void strcpy(char *dst, char *src)
 {
     while((*dst++ = *src++));
 }
 
+static struct page *alloc_buddy_pages(unsigned int order, unsigned int migratetype)
+{
+    struct list *freelist;
+    struct page *p;
+    unsigned int i = MAX_ORDER + 1;
+    p = alloc_buddy_pages_nofallback(order, migratetype);
+    if(p) {
+        return p;
+    }
+    while(i-- > order) {
+        freelist = &(freelists[!migratetype][i]);
+        if(!list_empty(freelist)) {
+            p = LIST_FIRST_ENTRY(freelist, struct page, pagelist);
+            list_delete(&(p->pagelist));
+            if(i == MAX_ORDER) {
+                p->migratetype = migratetype;
+            }
+            return split_buddy_pages(p, i, order);
+        }
+    }
+    return 0;
+}
+
+static struct page *alloc_buddy_pages_nofallback(unsigned int order, unsigned int migratetype)
+{
+    struct list *freelist;
+    struct page *p;
+    for(unsigned int i = order; i <= MAX_ORDER; i++) {
+        freelist = &(freelists[migratetype][i]);
+        if(!list_empty(freelist)) {
+            p = LIST_FIRST_ENTRY(freelist, struct page, pagelist);
+            list_delete(&(p->pagelist));
+            return split_buddy_pages(p, i, order);
+        }
+    }
+    return 0;
+}
+
 struct cache *alloc_cache(char *name, unsigned long objsize)
+{
+    return alloc_cache_ctor(name, objsize, 0, 0);
+}
+
+/*
+ * The ctor runs once per object, when its slab is created, not on every
+ * alloc_obj(). Objects come back from cake_free() as their last user left
+ * them, so callers must re-establish any field that changes while in use.
+ */
+struct cache *alloc_cache_ctor(char *name, unsigned long objsize,
+    void (*ctor)(void *obj), void (*dtor)(void *obj))
 {
     unsigned int lgrm, numpages, batchsize;
     struct cpucache **ref;
@@ -114,6 +251,8 @@ struct cache *alloc_cache(char *name, unsigned long objsize)
     cache->freecount = 0;
     cache->capacity = 0;
     cache->pageorder = lgrm;
+    cache->ctor = ctor;
+    cache->dtor = dtor;
     for(unsigned int i = 0; i < NUM_CPUS; i++) {
         cache->cpucaches[i] = ref[i];
     }
@@ -126,7 +265,9 @@ struct cache *alloc_cache(char *name, unsigned long objsize)
     li = &(cache->slabsfree);
     li->prev = li;
     li->next = li;
+    SPIN_LOCK(&cachelist_lock);
     list_add(&(cachelist), &(cache->cachelist));
+    SPIN_UNLOCK(&cachelist_lock);
     cake_free(ref);
     return cache;
 freecache:
@@ -139,6 +280,7 @@ static long alloc_cache_slab(struct cache *cache)
 {
     unsigned long slab_overhead = sizeof(struct slab);
     unsigned long free_tracking_size = cache->batchsize * sizeof(unsigned int);
+    unsigned long slab_end, leftover;
     struct page *page;
     struct slab *slab;
     void *memblock;
@@ -160,6 +302,12 @@ static long alloc_cache_slab(struct cache *cache)
             memblock += sizeof(void *);
         }
     }
+    slab_end = ((unsigned long) PAGE_TO_PTR(page)) + (PAGE_SIZE << cache->pageorder);
+    leftover = slab_end - ((unsigned long) memblock + (cache->batchsize * cache->objsize));
+    if(cache->colour_next > (leftover >> L1_CACHE_SHIFT)) {
+        cache->colour_next = 0;
+    }
+    memblock += (cache->colour_next++ << L1_CACHE_SHIFT);
     slab->page = page;
     slab->cache = cache;
     slab->block = memblock;
@@ -167,6 +315,9 @@ static long alloc_cache_slab(struct cache *cache)
     slab->next_free = 0;
     for(unsigned int i = 0; i < cache->batchsize; i++) {
         SLAB_FREE_STACK(slab)[i] = i;
+        if(cache->ctor) {
+            cache->ctor(memblock + (i * cache->objsize));
+        }
     }
     for(unsigned long i = page->pfn; i < page->pfn + (1 << cache->pageorder); i++) {
         struct page *p = &(system_phys_page_dir[i]);
@@ -176,14 +327,66 @@ static long alloc_cache_slab(struct cache *cache)
     list_add(&(cache->slabsfree), &(slab->slablist));
     cache->capacity += cache->batchsize;
     cache->freecount += cache->batchsize;
+    cache->grows++;
     return 0;
 freepage:
-    cake_free(page);
+    free_pages(page);
 nomem:
     return -ENOMEM;
 }
 
 
+static struct page *alloc_compact_target(unsigned int order)
+{
+    struct page *p;
+    lock_allocator();
+    p = alloc_buddy_pages_nofallback(order, MIGRATE_MOVABLE);
+    if(p) {
+        set_page_allocated(p, order, 1);
+        p->movable = 1;
+        p->mapping = 0;
+        p->refcount = 1;
+    }
+    SPIN_UNLOCK(&allocator_lock);
+    return p;
+}
+
+struct page *alloc_contig_pages(unsigned long numpages)
+{
+    struct page *page;
+    unsigned long align, next, start = 0;
+    if(!numpages || numpages > contig.numpages) {
+        return 0;
+    }
+    align = 1UL << (LOG2(numpages) < MAX_ORDER ? LOG2(numpages) : MAX_ORDER);
+    SPIN_LOCK(&(contig.lock));
+    while(1) {
+        start = ROUND_UP(find_next_zero_bit(contig.bitmap, start, contig.numpages), align);
+        if(start + numpages > contig.numpages) {
+            goto failure;
+        }
+        next = find_next_bit(contig.bitmap, start, start + numpages);
+        if(next == start + numpages) {
+            break;
+        }
+        start = next + 1;
+    }
+    for(unsigned long i = start; i < start + numpages; i++) {
+        set_bit(contig.bitmap, i);
+    }
+    set_bit(contig.ends, start + numpages - 1);
+    contig.freepages -= numpages;
+    contig.allocs++;
+    SPIN_UNLOCK(&(contig.lock));
+    page = &(GLOBAL_MEMMAP[contig.startpfn + start]);
+    page->refcount = 1;
+    return page;
+failure:
+    contig.failures++;
+    SPIN_UNLOCK(&(contig.lock));
+    return 0;
+}
+
 static struct cpucache **alloc_cpucaches()
 {
     long i;
@@ -227,11 +430,18 @@ void *alloc_obj(struct cache *cache)
     PREEMPT_DISABLE();
     cpuid = SMP_ID();
     cpucache = cache->cpucaches[cpuid];
-    if(!(cpucache->free)) {
-        SPIN_LOCK(&(cache->lock));
+    cache->touched[cpuid] = 1;
+    cache->stats[cpuid].allocs++;
+    if(cpucache->free) {
+        cache->stats[cpuid].hits++;
+    }
+    else {
+        cache->stats[cpuid].misses++;
+        lock_cache(cache);
         err = fill_cpucache(cache, cpucache);
         SPIN_UNLOCK(&(cache->lock));
         if(err) {
+            PREEMPT_ENABLE();
             return 0;
         }
     }
@@ -240,57 +450,125 @@ void *alloc_obj(struct cache *cache)
     return obj;
 }
 
-struct page *alloc_pages(unsigned int order)
+static struct page *alloc_pagecache_pages(unsigned int order)
 {
-    struct list *freelist;
-    struct page *buddy, *s;
+    struct pagecache *pagecache;
+    struct list *pagelist;
     struct page *p = 0;
-    unsigned long pfn, bpfn;
-    unsigned int i = order;
-    SPIN_LOCK(&allocator_lock);
-    while(i <= MAX_ORDER) {
-        freelist = &(freelists[i]);
-        if(!list_empty(freelist)) {
-            p = LIST_FIRST_ENTRY(freelist, struct page, pagelist);
-            list_delete(&(p->pagelist));
-            break;
-        }
-        i++;
+    PREEMPT_DISABLE();
+    pagecache = &(pagecaches[SMP_ID()]);
+    pagelist = &(pagecache->pagelists[order]);
+    if(list_empty(pagelist)) {
+        fill_pagecache(pagecache, order);
     }
-    SPIN_UNLOCK(&allocator_lock);
-    if(p) {
-        SPIN_LOCK(&allocator_lock);
-        while(i > order) {
-            --i;
-            p->current_order = i;
-            freelist = &(freelists[i]);
-            list_add(freelist, &(p->pagelist));
-            pfn = p->pfn;
-            bpfn = pfn + (1 << i);
-            buddy = &(GLOBAL_MEMMAP[bpfn]);
-            buddy->valid = 1;
-            buddy->original_order = i + 1;
-            buddy->current_order = i;
-            p = buddy;
+    if(!list_empty(pagelist)) {
+        p = LIST_FIRST_ENTRY(pagelist, struct page, pagelist);
+        list_delete(&(p->pagelist));
+        pagecache->count[order]--;
+        p->refcount = 1;
+    }
+    PREEMPT_ENABLE();
+    return p;
+}
+
+struct page *alloc_pages(unsigned int order)
+{
+    return alloc_pages_type(order, MIGRATE_UNMOVABLE);
+}
+
+unsigned int alloc_pages_bulk(unsigned int order, unsigned int n, struct page **pages)
+{
+    return alloc_pages_bulk_type(order, n, pages, MIGRATE_UNMOVABLE);
+}
+
+unsigned int alloc_pages_bulk_movable(unsigned int order, unsigned int n, struct page **pages)
+{
+    return alloc_pages_bulk_type(order, n, pages, MIGRATE_MOVABLE);
+}
+
+static unsigned int alloc_pages_bulk_type(unsigned int order, unsigned int n,
+    struct page **pages, unsigned int migratetype)
+{
+    unsigned int allocated = try_alloc_pages_bulk(order, n, pages, migratetype);
+    if(!allocated && reclaim_pages()) {
+        allocated = try_alloc_pages_bulk(order, n, pages, migratetype);
+    }
+    return allocated;
+}
+
+unsigned int alloc_pages_bulk_zeroed(unsigned int order, unsigned int n, struct page **pages)
+{
+    unsigned int hits = take_zeroed_pages(order, n, pages);
+    if(hits < n) {
+        if(!alloc_pages_bulk(order, n - hits, pages + hits)) {
+            free_pages_bulk(pages, hits);
+            return 0;
         }
-        SPIN_UNLOCK(&allocator_lock);
-        for(i = p->pfn; i < (p->pfn + (1 << order)); i++) {
-            s = &(GLOBAL_MEMMAP[i]);
-            s->allocated = 1;
+        for(unsigned int i = hits; i < n; i++) {
+            memset(PAGE_TO_PTR(pages[i]), 0, (PAGE_SIZE << order));
         }
-        p->refcount = 1;
+    }
+    return n;
+}
+
+struct page *alloc_pages_movable(unsigned int order)
+{
+    return alloc_pages_type(order, MIGRATE_MOVABLE);
+}
+
+struct page *alloc_pages_movable_zeroed(unsigned int order)
+{
+    struct page *page = alloc_pages_movable(order);
+    if(page) {
+        memset(PAGE_TO_PTR(page), 0, (PAGE_SIZE << order));
+    }
+    return page;
+}
+
+static struct page *alloc_pages_type(unsigned int order, unsigned int migratetype)
+{
+    struct page *p = try_alloc_pages(order, migratetype);
+    if(!p && reclaim_pages()) {
+        p = try_alloc_pages(order, migratetype);
+    }
+    if(!p && order && order <= MAX_ORDER && compact_pages(order)) {
+        p = try_alloc_pages(order, migratetype);
     }
     return p;
 }
 
+struct page *alloc_pages_zeroed(unsigned int order)
+{
+    struct page *page;
+    if(!alloc_pages_bulk_zeroed(order, 1, &page)) {
+        return 0;
+    }
+    return page;
+}
+
 void allocate_init()
 {
-    for(unsigned int i = 0; i <= MAX_ORDER; i++) {
-        struct list *freelist = &(freelists[i]);
-        freelist->next = freelist;
-        freelist->prev = freelist;
+    for(unsigned int i = 0; i < MIGRATE_TYPES; i++) {
+        for(unsigned int j = 0; j <= MAX_ORDER; j++) {
+            struct list *freelist = &(freelists[i][j]);
+            freelist->next = freelist;
+            freelist->prev = freelist;
+        }
     }
-    arch_populate_allocate_structures(freelists);
+    for(unsigned int i = 0; i < NUM_CPUS; i++) {
+        struct pagecache *pagecache = &(pagecaches[i]);
+        for(unsigned int j = 0; j <= PAGECACHE_MAX_ORDER; j++) {
+            struct list *pagelist = &(pagecache->pagelists[j]);
+            pagelist->next = pagelist;
+            pagelist->prev = pagelist;
+        }
+    }
+    for(unsigned int i = 0; i <= ZEROPOOL_MAX_ORDER; i++) {
+        struct list *pagelist = &(zeropool.pagelists[i]);
+        pagelist->next = pagelist;
+        pagelist->prev = pagelist;
+    }
+    total_pages = arch_populate_allocate_structures(freelists[MIGRATE_UNMOVABLE], &contig);
     setup_size_caches();
     setup_cache_cache();
 }
@@ -300,8 +578,8 @@ void *cake_alloc(unsigned long size)
     struct cache *sizecache;
     unsigned int index;
     index = cake_alloc_index(size);
-    if(index < 0) {
-        return 0;
+    if(index >= NUM_SIZE_CACHES) {
+        return cake_alloc_large(size);
     }
     sizecache = &(sizecaches[index]);
     return alloc_obj(sizecache);
@@ -309,55 +587,129 @@ void *cake_alloc(unsigned long size)
 
 static unsigned int cake_alloc_index(unsigned long size)
 {
-    if(size <= 32) {
-        return 0;
-    }
-    if(size <= 64) {
-        return 1;
-    }
-    if(size <= 128) {
-        return 2;
-    }
-    if(size <= 256) {
-        return 3;
-    }
-    if(size <= 512) {
-        return 4;
+    unsigned long rounded = (size ? size - 1 : 0) | ((1UL << MIN_SIZE_CACHE_ORDER) - 1);
+    return LOG2(rounded) + 1 - MIN_SIZE_CACHE_ORDER;
+}
+
+static void *cake_alloc_large(unsigned long size)
+{
+    unsigned int order;
+    struct page *page;
+    order = LOG2((size - 1) >> PAGE_SHIFT) + 1;
+    if(order > MAX_ORDER) {
+        page = alloc_contig_pages(DIV_ROUND_UP(size, PAGE_SIZE));
     }
-    if(size <= 1024) {
-        return 5;
+    else {
+        page = alloc_pages(order);
     }
-    if(size <= 2 * 1024) {
-        return 6;
+    if(!page) {
+        return 0;
     }
-    if(size <= 4 * 1024) {
-        return 7;
+    page->slab = 0;
+    page->cache = 0;
+    return PAGE_TO_PTR(page);
+}
+
+static int compact_pageblock(unsigned long startpfn)
+{
+    struct list isolated;
+    struct page *p, *new, *next;
+    unsigned long pfn, endpfn = startpfn + PAGEBLOCK_PAGES;
+    unsigned int order, movable = 0;
+    int err = 0;
+    isolated.next = &isolated;
+    isolated.prev = &isolated;
+    lock_allocator();
+    p = &(GLOBAL_MEMMAP[startpfn]);
+    if(p->migratetype != MIGRATE_MOVABLE || p->original_order != MAX_ORDER) {
+        goto unlock;
     }
-    if(size <= 8 * 1024) {
-        return 8;
+    for(pfn = startpfn; pfn < endpfn; pfn += (1UL << p->current_order)) {
+        p = &(GLOBAL_MEMMAP[pfn]);
+        if(p->allocated) {
+            if(!p->movable || p->refcount != 1 || !p->mapping) {
+                goto unlock;
+            }
+            movable++;
+        }
     }
-    if(size <= 16 * 1024) {
-        return 9;
+    if(!movable) {
+        goto unlock;
     }
-    if(size <= 32 * 1024) {
-        return 10;
+    for(pfn = startpfn; pfn < endpfn; pfn += (1UL << p->current_order)) {
+        p = &(GLOBAL_MEMMAP[pfn]);
+        if(!p->allocated) {
+            list_delete(&(p->pagelist));
+            set_page_allocated(p, p->current_order, 1);
+            list_add(&isolated, &(p->pagelist));
+        }
     }
-    if(size <= 64 * 1024) {
-        return 11;
+    SPIN_UNLOCK(&allocator_lock);
+    for(pfn = startpfn; pfn < endpfn; pfn += (1UL << order)) {
+        p = &(GLOBAL_MEMMAP[pfn]);
+        order = p->current_order;
+        if(!p->movable) {
+            continue;
+        }
+        new = alloc_compact_target(order);
+        if(!new) {
+            err = 1;
+            break;
+        }
+        if(new->pfn >= startpfn && new->pfn < endpfn) {
+            free_pages(new);
+            err = 1;
+            break;
+        }
+        if(migrate_mapped_pages(p, new)) {
+            free_pages(new);
+            err = 1;
+            break;
+        }
+        lock_allocator();
+        p->movable = 0;
+        p->refcount = 0;
+        list_add(&isolated, &(p->pagelist));
+        compact_migrated++;
+        SPIN_UNLOCK(&allocator_lock);
     }
-    if(size <= 128 * 1024) {
-        return 12;
+    lock_allocator();
+    LIST_FOR_EACH_ENTRY_SAFE(p, next, &isolated, pagelist) {
+        list_delete(&(p->pagelist));
+        set_page_allocated(p, p->current_order, 0);
+        free_buddy_pages(p);
     }
-    if(size <= 256 * 1024) {
-        return 13;
+    if(err) {
+        compact_failures++;
     }
-    if(size <= 512 * 1024) {
-        return 14;
+    else {
+        compact_successes++;
     }
-    if(size <= 1024 * 1024) {
-        return 15;
+    SPIN_UNLOCK(&allocator_lock);
+    return !err;
+unlock:
+    SPIN_UNLOCK(&allocator_lock);
+    return 0;
+}
+
+static int compact_pages(unsigned int order)
+{
+    int found;
+    for(unsigned long pfn = 0; pfn < total_pages; pfn += PAGEBLOCK_PAGES) {
+        if(!compact_pageblock(pfn)) {
+            continue;
+        }
+        found = 0;
+        lock_allocator();
+        for(unsigned int i = order; i <= MAX_ORDER && !found; i++) {
+            found = !list_empty(&(freelists[MIGRATE_MOVABLE][i]));
+        }
+        SPIN_UNLOCK(&allocator_lock);
+        if(found) {
+            return 1;
+        }
     }
-    return -1;
+    return 0;
 }
 
 void cake_free(void *obj)
@@ -365,13 +717,19 @@ void cake_free(void *obj)
     unsigned long cpuid;
     struct cpucache *cpucache;
     struct cache *cache;
+    cache = OBJ_CACHE(obj);
+    if(!cache) {
+        free_pages(&(PTR_TO_PAGE(obj)));
+        return;
+    }
     PREEMPT_DISABLE();
     cpuid = SMP_ID();
-    cache = OBJ_CACHE(obj);
     cpucache = cache->cpucaches[cpuid];
+    cache->touched[cpuid] = 1;
+    cache->stats[cpuid].frees++;
     CPUCACHE_DATA(cpucache)[cpucache->free++] = obj;
     if(cpucache->free == CPUCACHE_CAPACITY) {
-        SPIN_LOCK(&cache->lock);
+        lock_cache(cache);
         for(unsigned int i = CPUCACHE_CAPACITY; i > CPUCACHE_FILL_SIZE; i--) {
             free_object_to_cache_pool(cache, cpucache);
         }
@@ -380,6 +738,59 @@ void cake_free(void *obj)
     PREEMPT_ENABLE();
 }
 
+static void drain_cpucache(struct cache *cache, struct cpucache *cpucache)
+{
+    while(cpucache->free) {
+        free_object_to_cache_pool(cache, cpucache);
+    }
+}
+
+void drain_idle_cpucaches()
+{
+    unsigned long cpuid;
+    struct cache *cache;
+    struct cpucache *cpucache;
+    PREEMPT_DISABLE();
+    cpuid = SMP_ID();
+    if(!SPIN_TRYLOCK(&cachelist_lock)) {
+        goto done;
+    }
+    LIST_FOR_EACH_ENTRY(cache, &cachelist, cachelist) {
+        cpucache = cache->cpucaches[cpuid];
+        if(cache->touched[cpuid]) {
+            cache->touched[cpuid] = 0;
+            continue;
+        }
+        if(!(cpucache->free) || !SPIN_TRYLOCK(&(cache->lock))) {
+            continue;
+        }
+        drain_cpucache(cache, cpucache);
+        SPIN_UNLOCK(&(cache->lock));
+    }
+    SPIN_UNLOCK(&cachelist_lock);
+done:
+    PREEMPT_ENABLE();
+    if(XCHG_RELAXED(&shrink_pending, 0)) {
+        shrink_caches();
+    }
+}
+
+static void drain_pagecache(struct pagecache *pagecache, unsigned int order, unsigned int count)
+{
+    struct page *p;
+    struct list *pagelist = &(pagecache->pagelists[order]);
+    lock_allocator();
+    while(count-- && !list_empty(pagelist)) {
+        p = LIST_ENTRY(pagelist->prev, struct page, pagelist);
+        list_delete(&(p->pagelist));
+        pagecache->count[order]--;
+        set_page_allocated(p, order, 0);
+        free_buddy_pages(p);
+    }
+    SPIN_UNLOCK(&allocator_lock);
+    pagecache->drains++;
+}
+
 static long fill_cpucache(struct cache *cache, struct cpucache *cpucache)
 {
     while(cache->freecount < CPUCACHE_FILL_SIZE) {
@@ -393,35 +804,27 @@ static long fill_cpucache(struct cache *cache, struct cpucache *cpucache)
     return 0;
 }
 
-static void free_object_to_cache_pool(struct cache *cache, struct cpucache *cpucache)
+static void fill_pagecache(struct pagecache *pagecache, unsigned int order)
 {
-    void *obj = CPUCACHE_DATA(cpucache)[--cpucache->free];
-    struct slab *slab = OBJ_SLAB(obj);
-    unsigned long index = (obj - (slab->block)) / cache->objsize;
-    if(slab->usage == cache->batchsize) {
-        list_delete(&(slab->slablist));
-        list_add(&(cache->slabspart), &(slab->slablist));
-    }
-    SLAB_FREE_STACK(slab)[--slab->next_free] = (unsigned int) index;
-    cache->freecount++;
-    slab->usage--;
-    if(!slab->usage) {
-        list_delete(&(slab->slablist));
-        list_add(&(cache->slabsfree), &(slab->slablist));
+    struct page *p;
+    struct list *pagelist = &(pagecache->pagelists[order]);
+    lock_allocator();
+    for(unsigned int i = 0; i < PAGECACHE_BATCH(order); i++) {
+        p = alloc_buddy_pages(order, MIGRATE_UNMOVABLE);
+        if(!p) {
+            break;
+        }
+        set_page_allocated(p, order, 1);
+        list_enqueue(pagelist, &(p->pagelist));
+        pagecache->count[order]++;
     }
+    SPIN_UNLOCK(&allocator_lock);
+    pagecache->refills++;
 }
 
-void free_pages(struct page *page)
+static void free_buddy_pages(struct page *page)
 {
-    struct page *buddy, *s;
-    if(!atomic_dec_and_test(&(page->refcount))) {
-        return;
-    }
-    for(unsigned long i = page->pfn; i < (page->pfn + (1 << page->current_order)); i++) {
-        s = &(GLOBAL_MEMMAP[i]);
-        s->allocated = 0;
-    }
-    SPIN_LOCK(&allocator_lock);
+    struct page *buddy;
     while(1) {
         if(PAGE_IS_HEAD(page)) {
             buddy = TAIL_BUDDY(page);
@@ -448,8 +851,212 @@ void free_pages(struct page *page)
         }
         break;
     }
-    list_add(&(freelists[page->current_order]), &(page->pagelist));
+    list_add(PAGE_FREELIST(page, page->current_order), &(page->pagelist));
+}
+
+static void free_cache_slab(struct cache *cache, struct slab *slab)
+{
+    struct page *page = slab->page;
+    if(cache->dtor) {
+        for(unsigned int i = 0; i < cache->batchsize; i++) {
+            cache->dtor(slab->block + (i * cache->objsize));
+        }
+    }
+    list_delete(&(slab->slablist));
+    cache->capacity -= cache->batchsize;
+    cache->freecount -= cache->batchsize;
+    cache->shrinks++;
+    if(cache->objsize > ONSLAB_DESCRIPTOR_SIZE) {
+        cake_free(slab);
+    }
+    free_pages(page);
+}
+
+static void free_contig_pages(struct page *page)
+{
+    unsigned long end, start = page->pfn - contig.startpfn;
+    SPIN_LOCK(&(contig.lock));
+    end = find_next_bit(contig.ends, start, contig.numpages);
+    clear_bit(contig.ends, end);
+    for(unsigned long i = start; i <= end; i++) {
+        clear_bit(contig.bitmap, i);
+    }
+    contig.freepages += (end + 1 - start);
+    SPIN_UNLOCK(&(contig.lock));
+}
+
+static void free_object_to_cache_pool(struct cache *cache, struct cpucache *cpucache)
+{
+    void *obj = CPUCACHE_DATA(cpucache)[--cpucache->free];
+    struct slab *slab = OBJ_SLAB(obj);
+    unsigned long index = (obj - (slab->block)) / cache->objsize;
+    if(slab->usage == cache->batchsize) {
+        list_delete(&(slab->slablist));
+        list_add(&(cache->slabspart), &(slab->slablist));
+    }
+    SLAB_FREE_STACK(slab)[--slab->next_free] = (unsigned int) index;
+    cache->freecount++;
+    slab->usage--;
+    if(!slab->usage) {
+        list_delete(&(slab->slablist));
+        list_add(&(cache->slabsfree), &(slab->slablist));
+    }
+}
+
+void free_pages_bulk(struct page **pages, unsigned int n)
+{
+    struct pagecache *pagecache;
+    struct page *p;
+    unsigned int order;
+    int locked = 0;
+    PREEMPT_DISABLE();
+    pagecache = &(pagecaches[SMP_ID()]);
+    for(unsigned int i = 0; i < n; i++) {
+        p = pages[i];
+        if(!atomic_dec_and_test(&(p->refcount))) {
+            continue;
+        }
+        if(PAGE_IS_CONTIG(p)) {
+            free_contig_pages(p);
+            continue;
+        }
+        order = p->current_order;
+        if(order <= PAGECACHE_MAX_ORDER && !p->movable &&
+            pagecache->count[order] < PAGECACHE_HIGH(order)) {
+            list_add(&(pagecache->pagelists[order]), &(p->pagelist));
+            pagecache->count[order]++;
+            continue;
+        }
+        if(!locked) {
+            lock_allocator();
+            pagecache->drains++;
+            locked = 1;
+        }
+        p->movable = 0;
+        set_page_allocated(p, order, 0);
+        free_buddy_pages(p);
+    }
+    if(locked) {
+        SPIN_UNLOCK(&allocator_lock);
+    }
+    PREEMPT_ENABLE();
+}
+
+static void free_pagecache_pages(struct page *page)
+{
+    struct pagecache *pagecache;
+    unsigned int order = page->current_order;
+    PREEMPT_DISABLE();
+    pagecache = &(pagecaches[SMP_ID()]);
+    list_add(&(pagecache->pagelists[order]), &(page->pagelist));
+    pagecache->count[order]++;
+    if(pagecache->count[order] >= PAGECACHE_HIGH(order)) {
+        drain_pagecache(pagecache, order, PAGECACHE_BATCH(order));
+    }
+    PREEMPT_ENABLE();
+}
+
+void free_pages(struct page *page)
+{
+    if(!atomic_dec_and_test(&(page->refcount))) {
+        return;
+    }
+    if(PAGE_IS_CONTIG(page)) {
+        free_contig_pages(page);
+        return;
+    }
+    if(page->current_order <= PAGECACHE_MAX_ORDER && !page->movable) {
+        free_pagecache_pages(page);
+        return;
+    }
+    lock_allocator();
+    page->movable = 0;
+    set_page_allocated(page, page->current_order, 0);
+    free_buddy_pages(page);
+    SPIN_UNLOCK(&allocator_lock);
+}
+
+static int memstat_buddy(struct user_buddyinfo *user)
+{
+    struct user_buddyinfo info;
+    struct pagecache *pagecache;
+    struct page *p;
+    memset(&info, 0, sizeof(info));
+    info.orders = MAX_ORDER + 1;
+    lock_allocator();
+    for(unsigned int i = 0; i <= MAX_ORDER; i++) {
+        LIST_FOR_EACH_ENTRY(p, &(freelists[MIGRATE_UNMOVABLE][i]), pagelist) {
+            info.freeblocks[i]++;
+        }
+        LIST_FOR_EACH_ENTRY(p, &(freelists[MIGRATE_MOVABLE][i]), pagelist) {
+            info.freeblocks[i]++;
+            info.movableblocks[i]++;
+        }
+    }
+    info.compact_successes = compact_successes;
+    info.compact_failures = compact_failures;
+    info.compact_migrated = compact_migrated;
+    info.lock_acquires = allocator_lock_acquires;
+    info.lock_wait = allocator_lock_wait;
     SPIN_UNLOCK(&allocator_lock);
+    for(unsigned int i = 0; i < NUM_CPUS; i++) {
+        pagecache = &(pagecaches[i]);
+        for(unsigned int j = 0; j <= PAGECACHE_MAX_ORDER; j++) {
+            info.cachedblocks[j] += READ_ONCE(pagecache->count[j]);
+        }
+        info.refills += READ_ONCE(pagecache->refills);
+        info.drains += READ_ONCE(pagecache->drains);
+    }
+    SPIN_LOCK(&(zeropool.lock));
+    for(unsigned int i = 0; i <= ZEROPOOL_MAX_ORDER; i++) {
+        info.zeroedblocks[i] = zeropool.count[i];
+    }
+    info.zeroed_hits = zeropool.hits;
+    info.zeroed_misses = zeropool.misses;
+    SPIN_UNLOCK(&(zeropool.lock));
+    SPIN_LOCK(&(contig.lock));
+    info.contig_pages = contig.numpages;
+    info.contig_free = contig.freepages;
+    info.contig_allocs = contig.allocs;
+    info.contig_failures = contig.failures;
+    SPIN_UNLOCK(&(contig.lock));
+    return !copy_to_user(user, &info, sizeof(info));
+}
+
+static int memstat_slab(unsigned long index, struct user_slabinfo *user)
+{
+    struct user_slabinfo info;
+    struct cache *cache;
+    int found = 0;
+    memset(&info, 0, sizeof(info));
+    SPIN_LOCK(&cachelist_lock);
+    LIST_FOR_EACH_ENTRY(cache, &cachelist, cachelist) {
+        if(index--) {
+            continue;
+        }
+        strcpy(info.name, cache->name);
+        info.objsize = cache->objsize;
+        info.batchsize = cache->batchsize;
+        info.pageorder = cache->pageorder;
+        info.capacity = cache->capacity;
+        info.freecount = cache->freecount;
+        for(unsigned int i = 0; i < NUM_CPUS; i++) {
+            info.allocs += cache->stats[i].allocs;
+            info.frees += cache->stats[i].frees;
+            info.hits += cache->stats[i].hits;
+            info.misses += cache->stats[i].misses;
+        }
+        info.grows = cache->grows;
+        info.shrinks = cache->shrinks;
+        info.lock_wait = cache->lock_wait;
+        found = 1;
+        break;
+    }
+    SPIN_UNLOCK(&cachelist_lock);
+    if(!found) {
+        return 0;
+    }
+    return !copy_to_user(user, &info, sizeof(info));
 }
 
 static void *next_free_obj(struct cache *cache)
@@ -476,6 +1083,98 @@ static void *next_free_obj(struct cache *cache)
     return obj;
 }
 
+static unsigned long reclaim_pages()
+{
+    unsigned long reclaimed;
+    struct pagecache *pagecache;
+    struct page *p;
+    WRITE_ONCE(shrink_pending, 1);
+    reclaimed = reclaim_slabs(0, 0);
+    for(unsigned int i = 0; i <= ZEROPOOL_MAX_ORDER; i++) {
+        while(1) {
+            SPIN_LOCK(&(zeropool.lock));
+            if(list_empty(&(zeropool.pagelists[i]))) {
+                SPIN_UNLOCK(&(zeropool.lock));
+                break;
+            }
+            p = LIST_FIRST_ENTRY(&(zeropool.pagelists[i]), struct page, pagelist);
+            list_delete(&(p->pagelist));
+            zeropool.count[i]--;
+            SPIN_UNLOCK(&(zeropool.lock));
+            free_pages(p);
+            reclaimed += (1 << i);
+        }
+    }
+    PREEMPT_DISABLE();
+    pagecache = &(pagecaches[SMP_ID()]);
+    for(unsigned int i = 0; i <= PAGECACHE_MAX_ORDER; i++) {
+        if(pagecache->count[i]) {
+            reclaimed += pagecache->count[i] << i;
+            drain_pagecache(pagecache, i, pagecache->count[i]);
+        }
+    }
+    PREEMPT_ENABLE();
+    return reclaimed;
+}
+
+static unsigned long reclaim_slabs(unsigned int reserve, int offslab)
+{
+    unsigned int keep;
+    unsigned long cpuid, reclaimed = 0;
+    struct cache *cache;
+    struct slab *slab, *next;
+    PREEMPT_DISABLE();
+    cpuid = SMP_ID();
+    if(!SPIN_TRYLOCK(&cachelist_lock)) {
+        goto done;
+    }
+    LIST_FOR_EACH_ENTRY(cache, &cachelist, cachelist) {
+        if(!offslab && cache->objsize > ONSLAB_DESCRIPTOR_SIZE) {
+            continue;
+        }
+        if(!SPIN_TRYLOCK(&(cache->lock))) {
+            continue;
+        }
+        if(!reserve || !(cache->touched[cpuid])) {
+            drain_cpucache(cache, cache->cpucaches[cpuid]);
+        }
+        cache->touched[cpuid] = 0;
+        keep = reserve;
+        LIST_FOR_EACH_ENTRY_SAFE(slab, next, &(cache->slabsfree), slablist) {
+            if(keep) {
+                keep--;
+                continue;
+            }
+            free_cache_slab(cache, slab);
+            reclaimed += (1 << cache->pageorder);
+        }
+        SPIN_UNLOCK(&(cache->lock));
+    }
+    SPIN_UNLOCK(&cachelist_lock);
+done:
+    PREEMPT_ENABLE();
+    return reclaimed;
+}
+
+void refill_zeroed_pages()
+{
+    struct page *p;
+    for(unsigned int i = 0; i <= ZEROPOOL_MAX_ORDER; i++) {
+        while(READ_ONCE(zeropool.count[i]) < ZEROPOOL_TARGET(i)) {
+            p = try_alloc_pages(i, MIGRATE_UNMOVABLE);
+            if(!p) {
+                return;
+            }
+            ZERO_DCACHE_RANGE(PAGE_TO_PTR(p), (PAGE_SIZE << i));
+            SPIN_LOCK(&(zeropool.lock));
+            list_add(&(zeropool.pagelists[i]), &(p->pagelist));
+            zeropool.count[i]++;
+            zeropool.refills++;
+            SPIN_UNLOCK(&(zeropool.lock));
+        }
+    }
+}
+
 static unsigned int resize_batch(unsigned long numpages, unsigned long objsize)
 {
     unsigned long batchsize, tracking_overhead, slab_overhead, round_down_to_even_mask;
@@ -507,7 +1206,9 @@ static void setup_cache_cache()
     for(unsigned int i = 0; i < NUM_CPUS; i++) {
         cache->cpucaches[i] = ref[i];
     }
+    SPIN_LOCK(&cachelist_lock);
     list_add(&cachelist, &(cache->cachelist));
+    SPIN_UNLOCK(&cachelist_lock);
     cake_free(ref);
 }
 
@@ -534,6 +1235,7 @@ static void setup_size_caches()
         lgrm = LOG2_SAFE(numpages);
         lgrm = lgrm > MAX_ORDER ? MAX_ORDER : lgrm;
         batchsize = resize_batch((1 << lgrm), objsize);
+        size_cache_name(sizecache->name, objsize);
         sizecache->objsize = objsize;
         sizecache->batchsize = batchsize;
         sizecache->freecount = 0;
@@ -566,6 +1268,153 @@ static void setup_size_caches()
             CPUCACHE_DATA(new)[j] = CPUCACHE_DATA(old)[j];
         }
         cake_free(ref);
+        SPIN_LOCK(&cachelist_lock);
+        list_enqueue(&cachelist, &(sizecache->cachelist));
+        SPIN_UNLOCK(&cachelist_lock);
     }
     free_pages(page);
 }
+
+unsigned long shrink_caches()
+{
+    return reclaim_slabs(SLABSFREE_RESERVE, 1);
+}
+
+static void size_cache_name(char *name, unsigned long objsize)
+{
+    int len = 0;
+    char digits[20];
+    strcpy(name, "size-");
+    while(*name) {
+        name++;
+    }
+    do {
+        digits[len++] = '0' + (objsize % 10);
+        objsize /= 10;
+    } while(objsize);
+    while(len--) {
+        *(name++) = digits[len];
+    }
+    *name = '\0';
+}
+
+static struct page *split_buddy_pages(struct page *p, unsigned int from, unsigned int order)
+{
+    struct page *buddy;
+    while(from > order) {
+        --from;
+        p->current_order = from;
+        list_add(PAGE_FREELIST(p, from), &(p->pagelist));
+        buddy = &(GLOBAL_MEMMAP[p->pfn + (1 << from)]);
+        buddy->valid = 1;
+        buddy->original_order = from + 1;
+        buddy->current_order = from;
+        p = buddy;
+    }
+    return p;
+}
+
+int sys_memstat(unsigned long kind, unsigned long index, void *info)
+{
+    switch(kind) {
+        case MEMSTAT_BUDDY:
+            return index ? 0 : memstat_buddy(info);
+        case MEMSTAT_SLAB:
+            return memstat_slab(index, info);
+        default:
+            return 0;
+    }
+}
+
+static unsigned int take_zeroed_pages(unsigned int order, unsigned int n,
+    struct page **pages)
+{
+    unsigned int i = 0;
+    struct list *pagelist;
+    if(order > ZEROPOOL_MAX_ORDER) {
+        return 0;
+    }
+    pagelist = &(zeropool.pagelists[order]);
+    SPIN_LOCK(&(zeropool.lock));
+    while(i < n && !list_empty(pagelist)) {
+        pages[i] = LIST_FIRST_ENTRY(pagelist, struct page, pagelist);
+        list_delete(&(pages[i]->pagelist));
+        zeropool.count[order]--;
+        i++;
+    }
+    zeropool.hits += i;
+    zeropool.misses += (n - i);
+    SPIN_UNLOCK(&(zeropool.lock));
+    return i;
+}
+
+static struct page *try_alloc_pages(unsigned int order, unsigned int migratetype)
+{
+    struct page *p;
+    if(order > MAX_ORDER) {
+        return alloc_contig_pages(1UL << order);
+    }
+    if(order <= PAGECACHE_MAX_ORDER && migratetype == MIGRATE_UNMOVABLE) {
+        return alloc_pagecache_pages(order);
+    }
+    lock_allocator();
+    p = alloc_buddy_pages(order, migratetype);
+    if(p) {
+        set_page_allocated(p, order, 1);
+        p->movable = migratetype == MIGRATE_MOVABLE;
+        p->mapping = 0;
+        p->refcount = 1;
+    }
+    SPIN_UNLOCK(&allocator_lock);
+    return p;
+}
+
+static unsigned int try_alloc_pages_bulk(unsigned int order, unsigned int n,
+    struct page **pages, unsigned int migratetype)
+{
+    struct pagecache *pagecache;
+    struct list *pagelist;
+    struct page *p;
+    unsigned int i = 0;
+    if(order > MAX_ORDER) {
+        while(i < n && (pages[i] = alloc_contig_pages(1UL << order))) {
+            i++;
+        }
+        goto done;
+    }
+    PREEMPT_DISABLE();
+    if(order <= PAGECACHE_MAX_ORDER && migratetype == MIGRATE_UNMOVABLE) {
+        pagecache = &(pagecaches[SMP_ID()]);
+        pagelist = &(pagecache->pagelists[order]);
+        while(i < n && !list_empty(pagelist)) {
+            p = LIST_FIRST_ENTRY(pagelist, struct page, pagelist);
+            list_delete(&(p->pagelist));
+            pagecache->count[order]--;
+            pages[i++] = p;
+        }
+    }
+    if(i < n) {
+        lock_allocator();
+        while(i < n) {
+            p = alloc_buddy_pages(order, migratetype);
+            if(!p) {
+                break;
+            }
+            set_page_allocated(p, order, 1);
+            p->movable = migratetype == MIGRATE_MOVABLE;
+            p->mapping = 0;
+            pages[i++] = p;
+        }
+        SPIN_UNLOCK(&allocator_lock);
+    }
+    PREEMPT_ENABLE();
+    for(unsigned int j = 0; j < i; j++) {
+        pages[j]->refcount = 1;
+    }
+done:
+    if(i < n) {
+        free_pages_bulk(pages, i);
+        return 0;
+    }
+    return n;
+}
@@ -36,6 +36,8 @@ extern void signal_init();
 extern void smp_init();
 extern int startup_user(void *user_function);
 extern void timer_init();
+extern void timer_init_cpu();
+extern void timer_wheel_init();
 extern int USER_STARTUP_FUNCTION();
 
 static void init();
@@ -68,6 +70,8 @@ static void init()
     log("TIMER MODULE INITIALIZED\r\n");
     schedule_init();
     log("SCHEDULE MODULE INITIALIZED\r\n");
+    timer_wheel_init();
+    log("TIMER WHEEL MODULE INITIALIZED\r\n");
     smp_init();
     log("SMP MODULE INITIALIZED\r\n");
     allocate_init();
@@ -81,7 +85,8 @@ static void init()
     filesystem_init();
     log("FILESYSTEM MODULE INITIALIZED\r\n");
     cake_thread(startup_user, USER_STARTUP_FUNCTION, CLONE_CAKETHREAD | CLONE_PRIORITY_USER);
-    cake_thread(perform_work, (void *) 0, CLONE_CAKETHREAD | CLONE_PRIORITY_CAKE_THREAD);
+    cake_thread(perform_work, (void *) 0,
+        CLONE_CAKETHREAD | CLONE_PRIORITY_CAKE_THREAD | CLONE_SCHED_FIFO | CLONE_RT_PRIORITY_WORK);
 }
 
 void secondary_main()
@@ -89,6 +94,7 @@ void secondary_main()
     SPIN_LOCK_BOOT(&big_cake_lock);
     schedule_current();
     SPIN_UNLOCK_BOOT(&big_cake_lock);
+    timer_init_cpu();
     IRQ_ENABLE();
     do_idle();
 }
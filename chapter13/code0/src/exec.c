@@ -64,7 +64,7 @@ static struct virtualmem *user_vm_segment(unsigned long start_addr, unsigned lon
         if((end_addr - start_addr) > (1 << (PAGE_SHIFT + page_order))) {
             page_order += 1;
         }
-        copypage = alloc_pages(page_order);
+        copypage = alloc_pages_movable(page_order);
         if(!copypage) {
             goto freevirtualmem;
         }
@@ -89,11 +89,10 @@ static struct virtualmem *anonymous_vm_segment(unsigned long start_addr,
     if(!vm) {
         goto nomem;
     }
-    page = alloc_pages(page_order);
+    page = alloc_pages_movable_zeroed(page_order);
     if(!page) {
         goto freevirtualmem;
     }
-    memset(PAGE_TO_PTR(page), 0, (PAGE_SIZE << page_order));
     vm->mm = mm;
     vm->vm_start = start_addr;
     vm->vm_end = end_addr;
@@ -109,28 +108,20 @@ nomem:
 
 static void exec_mmap(struct memmap *mm, struct process *p)
 {
-    struct memmap *old_mm, *active_mm;
-    old_mm = p->memmap;
-    active_mm = p->active_memmap;
+    struct memmap *active_mm = p->active_memmap;
     p->memmap = mm;
     p->active_memmap = mm;
     memmap_switch(active_mm, mm, p);
-    if(old_mm) {
-        put_memmap(old_mm);
-    }
-    else {
-        drop_memmap(active_mm);
-    }
 }
 
 long do_exec(int (*user_function)(void), int init)
 {
     unsigned long heap_start, program_counter, flags;
     struct process *current;
-    struct memmap *mm;
+    struct memmap *mm, *old_mm, *active_mm;
     struct stack_save_registers *ssr;
     struct virtualmem *user_text, *user_rodata, *user_data, *user_bss;
-    struct virtualmem *heap, *stack;
+    struct virtualmem *heap, *stack, *vm;
     current = CURRENT;
     mm = alloc_memmap();
     if(!mm) {
@@ -185,9 +176,20 @@ long do_exec(int (*user_function)(void), int init)
     list_enqueue(&(mm->vmems), &(user_bss->vmlist));
     list_enqueue(&(mm->vmems), &(heap->vmlist));
     list_enqueue(&(mm->vmems), &(stack->vmlist));
-    flags = SPIN_LOCK_IRQSAVE(&(mm->lock));
+    LIST_FOR_EACH_ENTRY(vm, &(mm->vmems), vmlist) {
+        page_add_mapping(vm->page, vm);
+    }
+    old_mm = current->memmap;
+    active_mm = current->active_memmap;
+    flags = WRITE_LOCK_IRQSAVE(&(mm->lock));
     exec_mmap(mm, current);
-    SPIN_UNLOCK_IRQRESTORE(&(mm->lock), flags);
+    WRITE_UNLOCK_IRQRESTORE(&(mm->lock), flags);
+    if(old_mm) {
+        put_memmap(old_mm);
+    }
+    else {
+        drop_memmap(active_mm);
+    }
     start_thread(ssr, program_counter, STACK_TOP - SECTION_SIZE);
     return 0;
 freeheap:
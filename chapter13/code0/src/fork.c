@@ -26,6 +26,7 @@
 #include "arch/atomic.h"
 #include "arch/bare-metal.h"
 #include "arch/lock.h"
+#include "arch/page.h"
 #include "arch/schedule.h"
 #include "user/fork.h"
 #include "user/signal.h"
@@ -40,10 +41,15 @@ extern void init_mem_context(struct memmap *new);
 extern void memcpy(void *to, void *from, unsigned long count);
 extern void memset(void *dest, int c, unsigned long count);
 
+#define MAX_STACK_SEGMENTS  (((MAX_STACK_AREA) / (STACK_SIZE)) + 1)
+
 static long copy_signal(unsigned long flags, struct process *p);
 static long do_clone(unsigned long flags, unsigned long thread_input, unsigned long arg);
 static struct process *duplicate_current();
 static struct memmap *duplicate_memmap(struct memmap *old, struct process *p);
+static void memmap_ctor(void *obj);
+static void signal_ctor(void *obj);
+static void virtualmem_ctor(void *obj);
 
 static struct cache *memmap_cache;
 static struct cache *process_cache;
@@ -56,17 +62,14 @@ struct memmap *alloc_memmap()
     if(!mm) {
         goto nomem;
     }
-    struct page *page = alloc_pages(0);
+    struct page *page = alloc_pages_zeroed(0);
     if(!page) {
         goto freememmap;
     }
-    memset(mm, 0, sizeof(*mm));
-    mm->vmems.prev = &(mm->vmems);
-    mm->vmems.next = &(mm->vmems);
     mm->pgd = PAGE_TO_PTR(page);
-    memset(mm->pgd, 0, PAGE_SIZE);
     mm->users = 1;
     mm->refcount = 1;
+    init_mem_context(mm);
     return mm;
 freememmap:
     cake_free(mm);
@@ -76,14 +79,7 @@ nomem:
 
 struct virtualmem *alloc_virtualmem()
 {
-    struct virtualmem *vm = alloc_obj(virtualmem_cache);
-    if(!vm) {
-        return 0;
-    }
-    memset(vm, 0, sizeof(*vm));
-    vm->vmlist.prev = &(vm->vmlist);
-    vm->vmlist.next = &(vm->vmlist);
-    return vm;
+    return alloc_obj(virtualmem_cache);
 }
 
 int cake_thread(int (*fn)(void *), void *arg, unsigned long flags)
@@ -157,13 +153,16 @@ static long copy_signal(unsigned long flags, struct process *p)
     if(!signal) {
         return -ENOMEM;
     }
-    memset(signal, 0, sizeof(*signal));
+    signal->pending[0] = 0;
+    signal->blocked[0] = 0;
+    signal->flags = 0;
+    signal->exitcode = 0;
     signal->signallist.prev = &(signal->signallist);
     signal->signallist.next = &(signal->signallist);
-    signal->waitqueue.waitlist.prev = &(signal->waitqueue.waitlist);
-    signal->waitqueue.waitlist.next = &(signal->waitqueue.waitlist);
     for(int i = 0; i < NUM_SIGNALS; i++) {
+        signal->sighandler.sigaction[i].flags = 0;
         signal->sighandler.sigaction[i].fn = SIG_DFL;
+        signal->sighandler.sigaction[i].restore = 0;
     }
     signal->sighandler.sigaction[SIGCHLD - 1].fn = SIG_IGN;
     signal->refcount = 1;
@@ -171,10 +170,10 @@ static long copy_signal(unsigned long flags, struct process *p)
     return 0;
 }
 
-static struct virtualmem *copy_virtualmem(struct virtualmem *old)
+static struct virtualmem *copy_virtualmem(struct virtualmem *old, struct page *copy_page)
 {
     unsigned long copy_count;
-    struct page *page, *copy_page;
+    struct page *page;
     struct virtualmem *new = alloc_obj(virtualmem_cache);
     if(!new) {
         goto failure;
@@ -186,10 +185,6 @@ static struct virtualmem *copy_virtualmem(struct virtualmem *old)
     new->vmlist.prev = &(new->vmlist);
     new->vmlist.next = &(new->vmlist);
     if(VM_ISSTACK(old)) {
-        copy_page = alloc_pages(page->current_order);
-        if(!copy_page) {
-            goto freevirtualmem;
-        }
         copy_count = PAGE_SIZE << (page->current_order);
         memcpy(PAGE_TO_PTR(copy_page), PAGE_TO_PTR(page), copy_count);
         new->page = copy_page;
@@ -198,8 +193,6 @@ static struct virtualmem *copy_virtualmem(struct virtualmem *old)
         ATOMIC_LONG_INC(&(page->refcount));
     }
     return new;
-freevirtualmem:
-    cake_free(new);
 failure:
     return 0;
 }
@@ -225,7 +218,7 @@ static struct process *duplicate_current()
     if(!p) {
         goto nomem;
     }
-    stack = alloc_pages(STACK_SHIFT);
+    stack = alloc_pages_zeroed(STACK_SHIFT);
     if(!stack) {
         goto freeprocess;
     }
@@ -241,7 +234,6 @@ static struct process *duplicate_current()
     list_enqueue(&(current->childlist), &(p->siblinglist));
     SPIN_UNLOCK(&(current->lock));
     p->stack = PAGE_TO_PTR(stack);
-    memset(p->stack, 0, STACK_SIZE);
     return p;
 freeprocess:
     cake_free(p);
@@ -253,38 +245,66 @@ static struct memmap *duplicate_memmap(struct memmap *old, struct process *p)
 {
     struct memmap *new;
     struct virtualmem *old_vm, *new_vm, *dup_vm;
-    struct page *pgd;
+    struct page *pgd, *copy_page;
+    struct page *stacks[MAX_STACK_SEGMENTS];
+    unsigned int num_stacks = 0, next_stack = 0;
+    LIST_FOR_EACH_ENTRY(old_vm, &(old->vmems), vmlist) {
+        if(VM_ISSTACK(old_vm)) {
+            num_stacks++;
+        }
+    }
+    if(num_stacks > MAX_STACK_SEGMENTS) {
+        goto nomem;
+    }
     new = alloc_obj(memmap_cache);
     if(!new) {
         goto nomem;
     }
-    pgd = alloc_pages(0);
+    pgd = alloc_pages_zeroed(0);
     if(!pgd) {
         goto freememmap;
     }
+    if(num_stacks && !alloc_pages_bulk_movable(STACK_SHIFT, num_stacks, stacks)) {
+        goto freepgd;
+    }
     *new = *old;
     new->users = 1;
     new->refcount = 1;
-    new->lock.owner = 0;
-    new->lock.ticket = 0;
-    new->pgd = PAGE_TO_PTR(pgd);   
-    memset(new->pgd, 0, PAGE_SIZE);
+    new->lock.count = 0;
+    new->pgd = PAGE_TO_PTR(pgd);
     new->vmems.prev = &(new->vmems);
     new->vmems.next = &(new->vmems);
     init_mem_context(new);
+    READ_LOCK(&(old->lock));
     LIST_FOR_EACH_ENTRY(old_vm, &(old->vmems), vmlist) {
-        dup_vm = copy_virtualmem(old_vm);
+        if(VM_ISSTACK(old_vm) && next_stack == num_stacks) {
+            goto unlock;
+        }
+        copy_page = VM_ISSTACK(old_vm) ? stacks[next_stack] : 0;
+        dup_vm = copy_virtualmem(old_vm, copy_page);
         if(!dup_vm) {
-            goto freevirtualmems;
+            goto unlock;
+        }
+        if(copy_page) {
+            next_stack++;
         }
         dup_vm->mm = new;
         list_enqueue(&(new->vmems), &(dup_vm->vmlist));
+        page_add_mapping(dup_vm->page, dup_vm);
     }
+    READ_UNLOCK(&(old->lock));
     return new;
-freevirtualmems:
+unlock:
+    READ_UNLOCK(&(old->lock));
     LIST_FOR_EACH_ENTRY_SAFE(dup_vm, new_vm, &(new->vmems), vmlist) {
+        page_remove_mapping(dup_vm->page, dup_vm);
         cake_free(dup_vm);
     }
+    new->vmems.prev = &(new->vmems);
+    new->vmems.next = &(new->vmems);
+    free_pages_bulk(stacks, num_stacks);
+freepgd:
+    free_pages(pgd);
 freememmap:
     cake_free(new);
 nomem:
@@ -293,10 +313,11 @@ nomem:
 
 void fork_init()
 {
-    memmap_cache = alloc_cache("memmap", sizeof(struct memmap));
+    memmap_cache = alloc_cache_ctor("memmap", sizeof(struct memmap), memmap_ctor, 0);
     process_cache = alloc_cache("process", sizeof(struct process));
-    signal_cache = alloc_cache("signal", sizeof(struct signal));
-    virtualmem_cache = alloc_cache("virtualmem", sizeof(struct virtualmem));
+    signal_cache = alloc_cache_ctor("signal", sizeof(struct signal), signal_ctor, 0);
+    virtualmem_cache = alloc_cache_ctor("virtualmem", sizeof(struct virtualmem),
+        virtualmem_ctor, 0);
 }
 
 void free_process(struct process *p)
@@ -315,7 +336,33 @@ void free_process(struct process *p)
     cake_free(p);
 }
 
+static void memmap_ctor(void *obj)
+{
+    struct memmap *mm = obj;
+    memset(mm, 0, sizeof(*mm));
+    mm->vmems.prev = &(mm->vmems);
+    mm->vmems.next = &(mm->vmems);
+}
+
+static void signal_ctor(void *obj)
+{
+    struct signal *signal = obj;
+    memset(signal, 0, sizeof(*signal));
+    signal->signallist.prev = &(signal->signallist);
+    signal->signallist.next = &(signal->signallist);
+    signal->waitqueue.waitlist.prev = &(signal->waitqueue.waitlist);
+    signal->waitqueue.waitlist.next = &(signal->waitqueue.waitlist);
+}
+
 int sys_clone(unsigned long flags, unsigned long thread_input, unsigned long arg)
 {
     return do_clone(flags, thread_input, arg);
 }
+
+static void virtualmem_ctor(void *obj)
+{
+    struct virtualmem *vm = obj;
+    memset(vm, 0, sizeof(*vm));
+    vm->vmlist.prev = &(vm->vmlist);
+    vm->vmlist.next = &(vm->vmlist);
+}
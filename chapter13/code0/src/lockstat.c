@@ -0,0 +1,119 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config/config.h"
+#include "cake/bitops.h"
+#include "cake/compiler.h"
+#include "cake/lock.h"
+#include "cake/lockstat.h"
+#include "cake/user.h"
+#include "arch/atomic.h"
+#include "arch/barrier.h"
+#include "arch/timer.h"
+#include "user/lockstat.h"
+
+extern void memset(void *dest, int c, unsigned long count);
+
+#if LOCKSTAT
+static void lockstat_max(unsigned long *max, unsigned long value);
+static void lockstat_register(struct lockstat *site);
+#endif
+static void lockstat_name(char *dst, const char *src);
+
+static struct lockstat *lockstat_sites;
+
+#if LOCKSTAT
+void lockstat_acquire(struct spinlock *lock, struct lockstat *site, int contended,
+    unsigned long wait)
+{
+    if(!READ_ONCE(site->registered)) {
+        lockstat_register(site);
+    }
+    ATOMIC_LONG_INC(&(site->acquisitions));
+    if(contended) {
+        ATOMIC_LONG_INC(&(site->contended));
+        ATOMIC_LONG_ADD(&(site->wait_total), wait);
+        lockstat_max(&(site->wait_max), wait);
+    }
+    lock->site = site;
+    lock->acquired = TIMER_COUNT();
+}
+
+static void lockstat_max(unsigned long *max, unsigned long value)
+{
+    unsigned long old;
+    while(value > (old = READ_ONCE(*max))) {
+        if(CMPXCHG_RELAXED(max, old, value) == old) {
+            break;
+        }
+    }
+}
+
+static void lockstat_register(struct lockstat *site)
+{
+    struct lockstat *head;
+    if(test_and_set_bit(&(site->registered), 0)) {
+        return;
+    }
+    do {
+        head = READ_ONCE(lockstat_sites);
+        site->next = head;
+        SMP_WMB();
+    } while(CMPXCHG_RELAXED(&lockstat_sites, (unsigned long) head, (unsigned long) site) !=
+        (unsigned long) head);
+}
+
+void lockstat_release(struct spinlock *lock)
+{
+    unsigned long hold;
+    struct lockstat *site = lock->site;
+    if(!site) {
+        return;
+    }
+    lock->site = 0;
+    hold = TIMER_COUNT() - lock->acquired;
+    ATOMIC_LONG_ADD(&(site->hold_total), hold);
+    lockstat_max(&(site->hold_max), hold);
+}
+#endif
+
+static void lockstat_name(char *dst, const char *src)
+{
+    for(unsigned int i = 0; i < LOCKSTAT_NAME_LEN - 1 && src[i]; i++) {
+        dst[i] = src[i];
+    }
+}
+
+int sys_lockstat(unsigned long index, struct user_lockstat *user)
+{
+    struct user_lockstat info;
+    struct lockstat *site = READ_ONCE(lockstat_sites);
+    while(site && index--) {
+        site = READ_ONCE(site->next);
+    }
+    if(!site) {
+        return 0;
+    }
+    memset(&info, 0, sizeof(info));
+    lockstat_name(info.class, site->class);
+    lockstat_name(info.function, site->function);
+    info.line = site->line;
+    info.acquisitions = READ_ONCE(site->acquisitions);
+    info.contended = READ_ONCE(site->contended);
+    info.wait_total = READ_ONCE(site->wait_total);
+    info.wait_max = READ_ONCE(site->wait_max);
+    info.hold_total = READ_ONCE(site->hold_total);
+    info.hold_max = READ_ONCE(site->hold_max);
+    return !copy_to_user(user, &info, sizeof(info));
+}
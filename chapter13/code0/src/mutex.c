@@ -0,0 +1,93 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cake/compiler.h"
+#include "cake/list.h"
+#include "cake/mutex.h"
+#include "cake/process.h"
+#include "cake/schedule.h"
+#include "cake/wait.h"
+#include "arch/atomic.h"
+#include "arch/barrier.h"
+#include "arch/schedule.h"
+
+static int mutex_optimistic_spin(struct mutex *mutex, struct process *current);
+
+void mutex_init(struct mutex *mutex)
+{
+    mutex->owner = 0;
+    mutex->waitqueue.waitlist.prev = &(mutex->waitqueue.waitlist);
+    mutex->waitqueue.waitlist.next = &(mutex->waitqueue.waitlist);
+    mutex->waitqueue.lock.owner = 0;
+    mutex->waitqueue.lock.ticket = 0;
+}
+
+void mutex_lock(struct mutex *mutex)
+{
+    struct wait wait;
+    struct process *current = CURRENT;
+    if(mutex_trylock(mutex) || mutex_optimistic_spin(mutex, current)) {
+        return;
+    }
+    wait.sleeping = current;
+    wait.waitlist.prev = &(wait.waitlist);
+    wait.waitlist.next = &(wait.waitlist);
+    while(1) {
+        enqueue_wait(&(mutex->waitqueue), &wait, PROCESS_STATE_UNINTERRUPTIBLE);
+        if(mutex_trylock(mutex)) {
+            break;
+        }
+        schedule_self();
+    }
+    dequeue_wait(&(mutex->waitqueue), &wait);
+}
+
+static int mutex_optimistic_spin(struct mutex *mutex, struct process *current)
+{
+    int running;
+    unsigned long owner;
+    while(!READ_ONCE(current->need_resched)) {
+        owner = READ_ONCE(mutex->owner);
+        if(!owner) {
+            if(mutex_trylock(mutex)) {
+                return 1;
+            }
+            continue;
+        }
+        running = process_on_cpu((struct process *) owner);
+        SMP_RMB();
+        if(READ_ONCE(mutex->owner) != owner) {
+            continue;
+        }
+        if(!running) {
+            break;
+        }
+    }
+    return 0;
+}
+
+int mutex_trylock(struct mutex *mutex)
+{
+    return !READ_ONCE(mutex->owner) &&
+        !CMPXCHG_ACQUIRE(&(mutex->owner), 0, (unsigned long) CURRENT);
+}
+
+void mutex_unlock(struct mutex *mutex)
+{
+    STORE_RELEASE(&(mutex->owner), 0);
+    SMP_MB();
+    if(!list_empty(&(mutex->waitqueue.waitlist))) {
+        wake_waiter(&(mutex->waitqueue));
+    }
+}
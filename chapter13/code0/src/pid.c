@@ -24,7 +24,7 @@
 #include "arch/lock.h"
 #include "arch/schedule.h"
 
-#define PID_SHIFT       (9)
+#define PID_SHIFT       (11)
 #define NUM_PIDS        ((1) << PID_SHIFT)
 #define PID_MASK        ((NUM_PIDS) - 1)
 #define PIDMAP_SIZE     (BITMAP_SIZE(NUM_PIDS))
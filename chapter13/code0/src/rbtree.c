@@ -0,0 +1,262 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cake/rbtree.h"
+
+static void change_child(struct rbtree *tree, struct rbnode *parent,
+    struct rbnode *old, struct rbnode *new);
+static void erase_fixup(struct rbtree *tree, struct rbnode *node, struct rbnode *parent);
+static void insert_fixup(struct rbtree *tree, struct rbnode *node);
+static void rotate_left(struct rbtree *tree, struct rbnode *node);
+static void rotate_right(struct rbtree *tree, struct rbnode *node);
+
+static inline int is_black(struct rbnode *node)
+{
+    return !node || node->colour == RB_BLACK;
+}
+
+static void change_child(struct rbtree *tree, struct rbnode *parent,
+    struct rbnode *old, struct rbnode *new)
+{
+    if(!parent) {
+        tree->root = new;
+    }
+    else if(parent->left == old) {
+        parent->left = new;
+    }
+    else {
+        parent->right = new;
+    }
+}
+
+static void erase_fixup(struct rbtree *tree, struct rbnode *node, struct rbnode *parent)
+{
+    struct rbnode *sibling;
+    while(node != tree->root && is_black(node)) {
+        if(node == parent->left) {
+            sibling = parent->right;
+            if(!is_black(sibling)) {
+                sibling->colour = RB_BLACK;
+                parent->colour = RB_RED;
+                rotate_left(tree, parent);
+                sibling = parent->right;
+            }
+            if(is_black(sibling->left) && is_black(sibling->right)) {
+                sibling->colour = RB_RED;
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+            if(is_black(sibling->right)) {
+                sibling->left->colour = RB_BLACK;
+                sibling->colour = RB_RED;
+                rotate_right(tree, sibling);
+                sibling = parent->right;
+            }
+            sibling->colour = parent->colour;
+            parent->colour = RB_BLACK;
+            sibling->right->colour = RB_BLACK;
+            rotate_left(tree, parent);
+        }
+        else {
+            sibling = parent->left;
+            if(!is_black(sibling)) {
+                sibling->colour = RB_BLACK;
+                parent->colour = RB_RED;
+                rotate_right(tree, parent);
+                sibling = parent->left;
+            }
+            if(is_black(sibling->left) && is_black(sibling->right)) {
+                sibling->colour = RB_RED;
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+            if(is_black(sibling->left)) {
+                sibling->right->colour = RB_BLACK;
+                sibling->colour = RB_RED;
+                rotate_left(tree, sibling);
+                sibling = parent->left;
+            }
+            sibling->colour = parent->colour;
+            parent->colour = RB_BLACK;
+            sibling->left->colour = RB_BLACK;
+            rotate_right(tree, parent);
+        }
+        node = tree->root;
+    }
+    if(node) {
+        node->colour = RB_BLACK;
+    }
+}
+
+static void insert_fixup(struct rbtree *tree, struct rbnode *node)
+{
+    struct rbnode *parent, *grandparent, *uncle;
+    while((parent = node->parent) && parent->colour == RB_RED) {
+        grandparent = parent->parent;
+        if(parent == grandparent->left) {
+            uncle = grandparent->right;
+            if(!is_black(uncle)) {
+                parent->colour = RB_BLACK;
+                uncle->colour = RB_BLACK;
+                grandparent->colour = RB_RED;
+                node = grandparent;
+                continue;
+            }
+            if(node == parent->right) {
+                rotate_left(tree, parent);
+                node = parent;
+                parent = node->parent;
+            }
+            parent->colour = RB_BLACK;
+            grandparent->colour = RB_RED;
+            rotate_right(tree, grandparent);
+        }
+        else {
+            uncle = grandparent->left;
+            if(!is_black(uncle)) {
+                parent->colour = RB_BLACK;
+                uncle->colour = RB_BLACK;
+                grandparent->colour = RB_RED;
+                node = grandparent;
+                continue;
+            }
+            if(node == parent->left) {
+                rotate_right(tree, parent);
+                node = parent;
+                parent = node->parent;
+            }
+            parent->colour = RB_BLACK;
+            grandparent->colour = RB_RED;
+            rotate_left(tree, grandparent);
+        }
+    }
+    tree->root->colour = RB_BLACK;
+}
+
+void rb_erase(struct rbtree *tree, struct rbnode *node)
+{
+    struct rbnode *child, *parent, *successor;
+    unsigned long colour;
+    if(tree->leftmost == node) {
+        tree->leftmost = rb_next(node);
+    }
+    if(!node->left || !node->right) {
+        child = node->left ? node->left : node->right;
+        parent = node->parent;
+        colour = node->colour;
+        if(child) {
+            child->parent = parent;
+        }
+        change_child(tree, parent, node, child);
+    }
+    else {
+        successor = node->right;
+        while(successor->left) {
+            successor = successor->left;
+        }
+        child = successor->right;
+        parent = successor->parent;
+        colour = successor->colour;
+        if(parent == node) {
+            parent = successor;
+        }
+        else {
+            if(child) {
+                child->parent = parent;
+            }
+            parent->left = child;
+            successor->right = node->right;
+            node->right->parent = successor;
+        }
+        successor->left = node->left;
+        node->left->parent = successor;
+        successor->parent = node->parent;
+        successor->colour = node->colour;
+        change_child(tree, node->parent, node, successor);
+    }
+    if(colour == RB_BLACK) {
+        erase_fixup(tree, child, parent);
+    }
+}
+
+void rb_insert(struct rbtree *tree, struct rbnode *node,
+    int (*less)(struct rbnode *a, struct rbnode *b))
+{
+    struct rbnode *parent = 0;
+    struct rbnode **link = &(tree->root);
+    int leftmost = 1;
+    while(*link) {
+        parent = *link;
+        if(less(node, parent)) {
+            link = &(parent->left);
+        }
+        else {
+            link = &(parent->right);
+            leftmost = 0;
+        }
+    }
+    node->parent = parent;
+    node->left = 0;
+    node->right = 0;
+    node->colour = RB_RED;
+    *link = node;
+    if(leftmost) {
+        tree->leftmost = node;
+    }
+    insert_fixup(tree, node);
+}
+
+struct rbnode *rb_next(struct rbnode *node)
+{
+    struct rbnode *parent;
+    if(node->right) {
+        node = node->right;
+        while(node->left) {
+            node = node->left;
+        }
+        return node;
+    }
+    while((parent = node->parent) && node == parent->right) {
+        node = parent;
+    }
+    return parent;
+}
+
+static void rotate_left(struct rbtree *tree, struct rbnode *node)
+{
+    struct rbnode *pivot = node->right;
+    node->right = pivot->left;
+    if(pivot->left) {
+        pivot->left->parent = node;
+    }
+    pivot->parent = node->parent;
+    change_child(tree, node->parent, node, pivot);
+    pivot->left = node;
+    node->parent = pivot;
+}
+
+static void rotate_right(struct rbtree *tree, struct rbnode *node)
+{
+    struct rbnode *pivot = node->left;
+    node->left = pivot->right;
+    if(pivot->right) {
+        pivot->right->parent = node;
+    }
+    pivot->parent = node->parent;
+    change_child(tree, node->parent, node, pivot);
+    pivot->right = node;
+    node->parent = pivot;
+}
@@ -13,37 +13,143 @@
  */
 
 #include "config/config.h"
+#include "cake/allocate.h"
 #include "cake/bitops.h"
+#include "cake/error.h"
 #include "cake/lock.h"
 #include "cake/process.h"
+#include "cake/rbtree.h"
 #include "cake/schedule.h"
+#include "cake/timer.h"
 #include "cake/vm.h"
 #include "cake/work.h"
+#include "arch/barrier.h"
 #include "arch/irq.h"
 #include "arch/lock.h"
 #include "arch/schedule.h"
 #include "arch/smp.h"
+#include "arch/timer.h"
 #include "arch/vm.h"
 #include "user/cpu.h"
+#include "user/sched.h"
+
+#define BALANCE_TICKS           (16)
+#define CACHE_HOT_NSECS         (1000000UL)
+#define IDLE_BALANCE_NSECS      (4000000UL)
+#define IMBALANCE_PCT           (125)
+#define LOAD_DECAY_SHIFT        (3)
+#define ISOLATED_CPUMASK        ((ISOLATE_CPUS) & ~(1UL))
+#define LOAD_SHIFT              (10)
+#define PROCESS_MIGRATING       (2)
+#define PROCESS_QUEUED          (1)
+#define RR_TIMESLICE            (2)
 
 extern struct memmap idle_memmap;
 
 extern unsigned int allocate_pid(struct process *p);
 extern void free_process(struct process *p);
+extern void irq_send_reschedule(unsigned long cpu);
 extern void memset(void *dest, int c, unsigned long count);
+extern struct process *pid_process(unsigned int pid);
+extern void pid_put(unsigned int pid);
+extern int timer_nohz_stop();
+extern void timer_nohz_restart();
 
+static void check_preempt_wakeup(struct runqueue *rq, struct process *p);
 static void finish_switch(struct process *prev);
+static void idle_balance(struct runqueue *this_rq, unsigned long cpuid);
+static void load_balance(struct runqueue *this_rq, unsigned long cpuid);
+static void nohz_idle_enter(struct runqueue *rq, unsigned long cpuid);
+static void migrate_process(struct runqueue *rq, struct process *p);
+static void nohz_idle_exit(struct runqueue *rq, unsigned long cpuid);
+static struct process *pid_process_sched(int pid);
+static void preempt_current(struct process *current);
+static struct runqueue *process_runqueue_lock(struct process *p, unsigned long *flags);
+static void resched_current(struct runqueue *rq);
+static void schedule();
 static struct process *schedule_next(struct runqueue *rq);
 static struct runqueue *select_runqueue(unsigned long *cpumask, unsigned long threshold);
+static struct process *steal_process(struct runqueue *this_rq, struct runqueue *busiest,
+    unsigned long cpuid, unsigned long maxweight);
+static int vruntime_less(struct rbnode *a, struct rbnode *b);
 
+static volatile unsigned long broadcast_cpumask;
+static unsigned long cache_hot_cycles;
+static unsigned long idle_balance_cycles;
+static volatile unsigned long isolated_cpumask = ISOLATED_CPUMASK;
+static volatile unsigned long nohz_cpumask;
 static struct runqueue runqueues[NUM_CPUS];
+static unsigned long tick_count;
+
+static inline void dequeue_process(struct runqueue *rq, struct process *p)
+{
+    if(PROCESS_RT(p)) {
+        list_delete_reset(&(p->rtlist));
+        if(list_empty(&(rq->rtqueues[RT_QUEUE(p)]))) {
+            clear_bit(rq->rtmask, RT_QUEUE(p));
+        }
+        rq->nr_rt--;
+    }
+    else {
+        rb_erase(&(rq->timeline), &(p->runnode));
+    }
+    p->queued = 0;
+    rq->nr_running--;
+    rq->queued_weight -= (1 << p->priority);
+}
+
+static inline void enqueue_process(struct runqueue *rq, struct process *p, int head)
+{
+    if(PROCESS_RT(p)) {
+        if(head) {
+            list_add(&(rq->rtqueues[RT_QUEUE(p)]), &(p->rtlist));
+        }
+        else {
+            list_enqueue(&(rq->rtqueues[RT_QUEUE(p)]), &(p->rtlist));
+        }
+        set_bit(rq->rtmask, RT_QUEUE(p));
+        rq->nr_rt++;
+    }
+    else {
+        p->vruntime = p->runtime_counter >> p->priority;
+        rb_insert(&(rq->timeline), &(p->runnode), vruntime_less);
+    }
+    p->queued = PROCESS_QUEUED;
+    rq->nr_running++;
+    rq->queued_weight += (1 << p->priority);
+    SMP_MB();
+    if(test_bit(&nohz_cpumask, rq - runqueues)) {
+        clear_bit(&nohz_cpumask, rq - runqueues);
+    }
+}
 
 static inline int process_preemptable(struct process *current)
 {
     int preemptable = current->preempt_count == 0;
-    int countdown_complete = current->tick_countdown == 0;
+    int need_resched = READ_ONCE(current->need_resched);
     int running = current->state == PROCESS_STATE_RUNNING;
-    return preemptable && countdown_complete && running;
+    return preemptable && need_resched && running;
+}
+
+static void check_preempt_wakeup(struct runqueue *rq, struct process *p)
+{
+    struct process *current = rq->current;
+    if(current->need_resched) {
+        return;
+    }
+    if(current != &(rq->idle_task) && !rq->tick_stopped) {
+        if(PROCESS_RT(p)) {
+            if(PROCESS_RT(current) && p->rt_priority <= current->rt_priority) {
+                return;
+            }
+        }
+        else if(PROCESS_RT(current) ||
+            p->vruntime >= (current->runtime_counter >> current->priority)) {
+            return;
+        }
+    }
+    rq->wakeup_preempts++;
+    resched_current(rq);
 }
 
 static void context_switch(struct runqueue *rq, struct process *prev, struct process *next)
@@ -62,68 +168,262 @@ static void context_switch(struct runqueue *rq, struct process *prev, struct pro
         prev->active_memmap = 0;
         rq->saved_memmap = old;
     }
+    FPSIMD_SWITCH(prev);
     prev = CONTEXT_SWITCH(prev, next);
     finish_switch(prev);
 }
 
 void do_idle()
 {
+    unsigned long cpuid = SMP_ID();
+    struct runqueue *rq = &(runqueues[cpuid]);
     while (1) {
+        drain_idle_cpucaches();
+        refill_zeroed_pages();
+        nohz_idle_enter(rq, cpuid);
         WAIT_FOR_INTERRUPT();
+        nohz_idle_exit(rq, cpuid);
     }
 }
 
 static void finish_switch(struct process *prev)
 {
-    unsigned long cpuid, priority, threshold;
-    struct runqueue *this_rq, *new_rq;
+    struct runqueue *rq;
     struct memmap *mm;
-    cpuid = SMP_ID();
-    this_rq = &(runqueues[cpuid]);
-    mm = this_rq->saved_memmap;
-    this_rq->saved_memmap = 0;
-    if(prev != &(this_rq->idle_task) && !(prev->state == PROCESS_STATE_EXIT)) {
-        priority = 1 << prev->priority;
-        threshold = this_rq->weight - priority;
-        new_rq = select_runqueue(prev->cpumask, threshold);
-        if(new_rq) {
-            this_rq->weight -= priority;
-            list_delete(&(prev->processlist));
-            SPIN_UNLOCK(&(this_rq->lock));
-            SPIN_LOCK(&(new_rq->lock));
-            list_add(&(new_rq->queue), &(prev->processlist));
-            new_rq->weight += priority;
-            SPIN_UNLOCK(&(new_rq->lock));
-            goto unlocked;
-        }
+    rq = &(runqueues[SMP_ID()]);
+    mm = rq->saved_memmap;
+    rq->saved_memmap = 0;
+    if(prev->state == PROCESS_STATE_EXIT) {
+        rq->weight -= (1 << prev->priority);
     }
-    SPIN_UNLOCK(&(this_rq->lock));
-unlocked:
+    SPIN_UNLOCK(&(rq->lock));
     if(mm) {
         drop_memmap(mm);
     }
     if(prev->state == PROCESS_STATE_EXIT) {
-        priority = 1 << prev->priority;
-        this_rq->weight -= priority;
-        list_delete(&(prev->processlist));
         free_process(prev);
     }
+    else if(prev->queued == PROCESS_MIGRATING) {
+        runqueue_process(prev);
+    }
     IRQ_ENABLE();
 }
 
+static void idle_balance(struct runqueue *this_rq, unsigned long cpuid)
+{
+    unsigned long now, max;
+    struct runqueue *rq, *busiest;
+    struct process *p;
+    now = TIMER_COUNT();
+    if(now < this_rq->next_balance || test_bit(&isolated_cpumask, cpuid)) {
+        return;
+    }
+    this_rq->next_balance = now + idle_balance_cycles;
+    busiest = 0;
+    max = 0;
+    for(unsigned long cpu = 0; cpu < NUM_CPUS; cpu++) {
+        rq = &(runqueues[cpu]);
+        if(test_bit(&isolated_cpumask, cpu)) {
+            continue;
+        }
+        if(rq != this_rq && READ_ONCE(rq->nr_running) > max) {
+            busiest = rq;
+            max = rq->nr_running;
+        }
+    }
+    if(!busiest) {
+        return;
+    }
+    if(!SPIN_TRYLOCK(&(busiest->lock))) {
+        goto fail;
+    }
+    p = steal_process(this_rq, busiest, cpuid, -1UL);
+    SPIN_UNLOCK(&(busiest->lock));
+    if(!p) {
+        goto fail;
+    }
+    this_rq->pulls++;
+    return;
+fail:
+    this_rq->pull_failures++;
+}
+
+static void load_balance(struct runqueue *this_rq, unsigned long cpuid)
+{
+    unsigned long max, imbalance, load;
+    struct runqueue *rq, *busiest;
+    struct process *p;
+    busiest = 0;
+    max = this_rq->load_avg;
+    for(unsigned long cpu = 0; cpu < NUM_CPUS; cpu++) {
+        rq = &(runqueues[cpu]);
+        if(test_bit(&isolated_cpumask, cpu)) {
+            continue;
+        }
+        if(rq != this_rq && READ_ONCE(rq->load_avg) > max) {
+            busiest = rq;
+            max = rq->load_avg;
+        }
+    }
+    if(!busiest || (max * 100) < (this_rq->load_avg * IMBALANCE_PCT)) {
+        return;
+    }
+    imbalance = (max - this_rq->load_avg) >> LOAD_SHIFT;
+    if(!SPIN_TRYLOCK(&(busiest->lock))) {
+        return;
+    }
+    p = steal_process(this_rq, busiest, cpuid, imbalance >> 1);
+    if(p) {
+        load = (1UL << p->priority) << LOAD_SHIFT;
+        busiest->load_avg -= busiest->load_avg < load ? busiest->load_avg : load;
+        this_rq->load_avg += load;
+        this_rq->balance_pulls++;
+    }
+    SPIN_UNLOCK(&(busiest->lock));
+}
+
+static void migrate_process(struct runqueue *rq, struct process *p)
+{
+    p->queued = PROCESS_MIGRATING;
+    rq->weight -= (1 << p->priority);
+}
+
+static void nohz_idle_enter(struct runqueue *rq, unsigned long cpuid)
+{
+    if(READ_ONCE(rq->nr_running)) {
+        return;
+    }
+    rq->nohz = 1;
+    rq->nohz_tick = READ_ONCE(tick_count);
+    rq->nohz_received = READ_ONCE(rq->ticks);
+    rq->nohz_stopped = timer_nohz_stop();
+    if(rq->nohz_stopped) {
+        set_bit(&broadcast_cpumask, cpuid);
+    }
+    set_bit(&nohz_cpumask, cpuid);
+    SMP_MB();
+    if(READ_ONCE(rq->nr_running)) {
+        clear_bit(&nohz_cpumask, cpuid);
+    }
+}
+
+static void nohz_idle_exit(struct runqueue *rq, unsigned long cpuid)
+{
+    unsigned long flags, missed;
+    if(!rq->nohz) {
+        return;
+    }
+    rq->wakeups++;
+    clear_bit(&nohz_cpumask, cpuid);
+    rq->nohz = 0;
+    if(rq->nohz_stopped) {
+        rq->nohz_stopped = 0;
+        timer_nohz_restart();
+        clear_bit(&broadcast_cpumask, cpuid);
+    }
+    flags = SPIN_LOCK_IRQSAVE(&(rq->lock));
+    missed = READ_ONCE(tick_count) - rq->nohz_tick;
+    missed -= rq->ticks - rq->nohz_received;
+    if((long) missed > 0) {
+        rq->idle_task.runtime_counter += missed;
+        rq->nohz_skipped += missed;
+        while(missed-- && (rq->load_avg >> LOAD_DECAY_SHIFT)) {
+            rq->load_avg -= rq->load_avg >> LOAD_DECAY_SHIFT;
+        }
+    }
+    SPIN_UNLOCK_IRQRESTORE(&(rq->lock), flags);
+}
+
+static void preempt_current(struct process *current)
+{
+    if(process_preemptable(current)) {
+        PREEMPT_DISABLE();
+        IRQ_ENABLE();
+        schedule();
+        IRQ_DISABLE();
+        PREEMPT_ENABLE();
+    }
+}
+
+void preempt_schedule()
+{
+    struct process *current = CURRENT;
+    if(IRQ_DISABLED()) {
+        return;
+    }
+    while(process_preemptable(current)) {
+        current->preempt_count++;
+        BARRIER();
+        schedule();
+        BARRIER();
+        current->preempt_count--;
+    }
+}
+
+static struct process *pid_process_sched(int pid)
+{
+    if(pid < 0 || (pid && pid < NUM_CPUS)) {
+        return 0;
+    }
+    return pid ? pid_process(pid) : CURRENT;
+}
+
+int process_on_cpu(struct process *p)
+{
+    for(unsigned long cpu = 0; cpu < NUM_CPUS; cpu++) {
+        if(READ_ONCE(runqueues[cpu].current) == p) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static struct runqueue *process_runqueue_lock(struct process *p, unsigned long *flags)
+{
+    struct runqueue *rq;
+    while(1) {
+        rq = &(runqueues[READ_ONCE(p->cpu)]);
+        *flags = SPIN_LOCK_IRQSAVE(&(rq->lock));
+        if(rq == &(runqueues[p->cpu])) {
+            return rq;
+        }
+        SPIN_UNLOCK_IRQRESTORE(&(rq->lock), *flags);
+    }
+}
+
+static void resched_current(struct runqueue *rq)
+{
+    unsigned long cpu;
+    WRITE_ONCE(rq->current->need_resched, 1);
+    cpu = rq - runqueues;
+    if(cpu != SMP_ID()) {
+        irq_send_reschedule(cpu);
+    }
+}
+
+void reschedule_interrupt()
+{
+    struct process *current = CURRENT;
+    runqueues[SMP_ID()].resched_ipis++;
+    preempt_current(current);
+}
+
 void runqueue_process(struct process *process)
 {
     unsigned long flags;
     struct runqueue *rq = select_runqueue(process->cpumask, -1UL);
     flags = SPIN_LOCK_IRQSAVE(&(rq->lock));
-    list_add(&(rq->queue), &(process->processlist));
+    process->cpu = rq - runqueues;
+    process->last_ran = 0;
+    enqueue_process(rq, process, 0);
     rq->weight += (1 << process->priority);
+    check_preempt_wakeup(rq, process);
     SPIN_UNLOCK_IRQRESTORE(&(rq->lock), flags);
 }
 
 static void schedule()
 {
-    unsigned long cpuid;
+    unsigned long cpuid, start;
     struct runqueue *rq;
     struct process *prev, *next;
     struct spinlock *rqlock;
@@ -131,10 +431,33 @@ static void schedule()
     cpuid = SMP_ID();
     rq = &(runqueues[cpuid]);
     rqlock = &(rq->lock);
+    if(rq->nohz) {
+        nohz_idle_exit(rq, cpuid);
+    }
     SPIN_LOCK(rqlock);
+    start = TIMER_COUNT();
     prev = rq->current;
+    prev->last_ran = start;
+    prev->need_resched = 0;
+    if(prev != &(rq->idle_task) && prev->state == PROCESS_STATE_RUNNING) {
+        if(test_bit(prev->cpumask, cpuid)) {
+            enqueue_process(rq, prev, prev->policy == SCHED_FIFO || prev->tick_countdown > 0);
+        }
+        else {
+            migrate_process(rq, prev);
+        }
+    }
+    if(!rq->nr_running) {
+        idle_balance(rq, cpuid);
+    }
     next = schedule_next(rq);
+    rq->schedule_time += TIMER_COUNT() - start;
+    rq->schedule_count++;
     if(next != prev) {
+        if(rq->tick_stopped) {
+            rq->tick_stopped = 0;
+            timer_nohz_restart();
+        }
         rq->switch_count++;
         rq->current = next;
         context_switch(rq, prev, next);
@@ -157,19 +480,56 @@ void schedule_init()
 {
     struct runqueue *rq;
     struct process *p;
-    struct list *q;
+    unsigned long frequency = TIMER_FREQUENCY();
+    cache_hot_cycles = (frequency * CACHE_HOT_NSECS) / NSECS_PER_SEC;
+    idle_balance_cycles = (frequency * IDLE_BALANCE_NSECS) / NSECS_PER_SEC;
     for(unsigned int i = 0; i < NUM_CPUS; i++) {
         rq = &(runqueues[i]);
         p = &(rq->idle_task);
-        q = &(rq->queue);
         rq->switch_count = 0;
         rq->weight = 0;
+        rq->nr_running = 0;
+        rq->nr_rt = 0;
+        rq->schedule_count = 0;
+        rq->schedule_time = 0;
+        rq->next_balance = 0;
+        rq->queued_weight = 0;
+        rq->load_avg = 0;
+        rq->balance_countdown = BALANCE_TICKS;
+        rq->balance_pulls = 0;
+        rq->nohz = 0;
+        rq->nohz_stopped = 0;
+        rq->tick_stopped = 0;
+        rq->nohz_tick = 0;
+        rq->nohz_received = 0;
+        rq->nohz_skipped = 0;
+        rq->ticks = 0;
+        rq->wakeups = 0;
+        rq->wakeup_preempts = 0;
+        rq->resched_ipis = 0;
+        rq->pulls = 0;
+        rq->pull_failures = 0;
+        rq->pull_hot = 0;
+        rq->timeline.root = 0;
+        rq->timeline.leftmost = 0;
+        bitmap_zero(rq->rtmask, RT_QUEUES);
+        for(unsigned int j = 0; j < RT_QUEUES; j++) {
+            rq->rtqueues[j].prev = &(rq->rtqueues[j]);
+            rq->rtqueues[j].next = &(rq->rtqueues[j]);
+        }
         rq->current = p;
         p->state = PROCESS_STATE_RUNNING;
         p->pid = i;
         p->priority = 0;
+        p->policy = SCHED_NORMAL;
+        p->rt_priority = 0;
         p->tick_countdown = 0;
         p->runtime_counter = 0;
+        p->vruntime = 0;
+        p->last_ran = 0;
+        p->cpu = i;
+        p->queued = 0;
+        p->need_resched = 0;
         p->stack = 0;
         p->preempt_count = 0;
         p->memmap = 0;
@@ -178,28 +538,26 @@ void schedule_init()
         p->childlist.prev = &(p->childlist);
         p->childlist.next = &(p->childlist);
         set_bit(p->cpumask, i);
-        q->prev = q;
-        q->next = q;
     }
     schedule_current();
 }
 
 static struct process *schedule_next(struct runqueue *rq)
 {
-    unsigned long n, c = -1;
-    struct process *p, *next = 0;
-    struct list *q = &(rq->queue);
-    LIST_FOR_EACH_ENTRY(p, q, processlist) {
-        if(!p->state) {
-            n = p->runtime_counter >> p->priority;
-            if(!next || c > n) {
-                next = p;
-                c = n;
-            }
+    struct process *next = &(rq->idle_task);
+    struct rbnode *first = RB_FIRST(&(rq->timeline));
+    unsigned long queue = find_next_bit(rq->rtmask, 0, RT_QUEUES);
+    if(queue < RT_QUEUES) {
+        next = LIST_FIRST_ENTRY(&(rq->rtqueues[queue]), struct process, rtlist);
+        dequeue_process(rq, next);
+        if(next->tick_countdown <= 0) {
+            next->tick_countdown = RR_TIMESLICE;
         }
+        return next;
     }
-    if(!next) {
-        next = &(rq->idle_task);
+    if(first) {
+        next = RB_ENTRY(first, struct process, runnode);
+        dequeue_process(rq, next);
     }
     next->tick_countdown = (1 << next->priority);
     return next;
@@ -222,12 +580,14 @@ static struct runqueue *select_runqueue(unsigned long *cpumask, unsigned long th
 {
     struct runqueue *rq = 0;
     unsigned long min = threshold;
-    for(unsigned long cpu = 0; cpu < NUM_CPUS; cpu++) {
-        if(test_bit(cpumask, cpu)) {
-            struct runqueue *compare = &(runqueues[cpu]);
-            if(compare->weight < min) {
-                rq = compare;
-                min = compare->weight;
+    for(int isolated = 0; !rq && isolated < 2; isolated++) {
+        for(unsigned long cpu = 0; cpu < NUM_CPUS; cpu++) {
+            if(test_bit(cpumask, cpu) && test_bit(&isolated_cpumask, cpu) == isolated) {
+                struct runqueue *compare = &(runqueues[cpu]);
+                if(compare->weight < min) {
+                    rq = compare;
+                    min = compare->weight;
+                }
             }
         }
     }
@@ -244,19 +604,242 @@ int sys_cpustat(unsigned long cpu, struct user_cpuinfo *cpuinfo)
     cpuinfo->cpu = cpu;
     cpuinfo->weight = rq->weight;
     cpuinfo->pid = rq->current->pid;
+    cpuinfo->runnable = rq->nr_running;
+    cpuinfo->schedules = rq->schedule_count;
+    cpuinfo->schedule_time = rq->schedule_time;
+    cpuinfo->pulls = rq->pulls;
+    cpuinfo->pull_failures = rq->pull_failures;
+    cpuinfo->pull_hot = rq->pull_hot;
+    cpuinfo->load_avg = (rq->load_avg * 100) >> LOAD_SHIFT;
+    cpuinfo->balance_pulls = rq->balance_pulls;
+    cpuinfo->ticks = rq->ticks;
+    cpuinfo->wakeups = rq->wakeups;
+    cpuinfo->nohz_skipped = rq->nohz_skipped;
+    cpuinfo->wakeup_preempts = rq->wakeup_preempts;
+    cpuinfo->resched_ipis = rq->resched_ipis;
+    cpuinfo->isolated = test_bit(&isolated_cpumask, cpu);
     return 1;
 }
 
+int sys_sched_getaffinity(int pid, unsigned long size, unsigned long *cpumask)
+{
+    struct process *p;
+    if(size < sizeof(p->cpumask)) {
+        return -EINVAL;
+    }
+    p = pid_process_sched(pid);
+    if(!p) {
+        return -ESRCH;
+    }
+    for(unsigned int i = 0; i < CPUMASK_SIZE; i++) {
+        cpumask[i] = READ_ONCE(p->cpumask[i]);
+    }
+    if(pid) {
+        pid_put(pid);
+    }
+    return 0;
+}
+
+int sys_sched_setaffinity(int pid, unsigned long size, unsigned long *cpumask)
+{
+    unsigned long flags, cpu;
+    unsigned long allowed[CPUMASK_SIZE];
+    int empty = 1, migrate = 0;
+    struct process *p;
+    struct runqueue *rq;
+    if(size < sizeof(allowed)) {
+        return -EINVAL;
+    }
+    bitmap_zero(allowed, NUM_CPUS);
+    for(cpu = 0; cpu < NUM_CPUS; cpu++) {
+        if(test_bit(cpumask, cpu)) {
+            set_bit(allowed, cpu);
+            empty = 0;
+        }
+    }
+    if(empty) {
+        return -EINVAL;
+    }
+    p = pid_process_sched(pid);
+    if(!p) {
+        return -ESRCH;
+    }
+    rq = process_runqueue_lock(p, &flags);
+    for(unsigned int i = 0; i < CPUMASK_SIZE; i++) {
+        p->cpumask[i] = allowed[i];
+    }
+    if(!test_bit(allowed, rq - runqueues)) {
+        if(rq->current == p) {
+            resched_current(rq);
+        }
+        else if(p->queued == PROCESS_QUEUED) {
+            dequeue_process(rq, p);
+            migrate_process(rq, p);
+            migrate = 1;
+        }
+    }
+    SPIN_UNLOCK_IRQRESTORE(&(rq->lock), flags);
+    if(migrate) {
+        runqueue_process(p);
+    }
+    if(pid) {
+        pid_put(pid);
+    }
+    return 0;
+}
+
+int sys_sched_setscheduler(int pid, int policy, int priority)
+{
+    unsigned long flags;
+    unsigned int queued;
+    struct process *p;
+    struct runqueue *rq;
+    if(policy == SCHED_NORMAL) {
+        if(priority) {
+            return -EINVAL;
+        }
+    }
+    else if(policy == SCHED_FIFO || policy == SCHED_RR) {
+        if(priority < 1 || priority > SCHED_RT_PRIORITY_MAX) {
+            return -EINVAL;
+        }
+    }
+    else {
+        return -EINVAL;
+    }
+    p = pid_process_sched(pid);
+    if(!p) {
+        return -ESRCH;
+    }
+    rq = process_runqueue_lock(p, &flags);
+    queued = p->queued == PROCESS_QUEUED;
+    if(queued) {
+        dequeue_process(rq, p);
+    }
+    p->policy = policy;
+    p->rt_priority = priority;
+    if(queued) {
+        enqueue_process(rq, p, 0);
+        check_preempt_wakeup(rq, p);
+    }
+    else if(rq->current == p) {
+        resched_current(rq);
+    }
+    SPIN_UNLOCK_IRQRESTORE(&(rq->lock), flags);
+    if(pid) {
+        pid_put(pid);
+    }
+    return 0;
+}
+
+static struct process *steal_process(struct runqueue *this_rq, struct runqueue *busiest,
+    unsigned long cpuid, unsigned long maxweight)
+{
+    unsigned long now, weight;
+    struct process *p;
+    struct rbnode *node;
+    now = TIMER_COUNT();
+    for(node = RB_FIRST(&(busiest->timeline)); node; node = rb_next(node)) {
+        p = RB_ENTRY(node, struct process, runnode);
+        weight = 1 << p->priority;
+        if(!test_bit(p->cpumask, cpuid) || weight > maxweight) {
+            continue;
+        }
+        if(now - p->last_ran < cache_hot_cycles) {
+            this_rq->pull_hot++;
+            continue;
+        }
+        dequeue_process(busiest, p);
+        busiest->weight -= weight;
+        WRITE_ONCE(p->cpu, cpuid);
+        enqueue_process(this_rq, p, 0);
+        this_rq->weight += weight;
+        return p;
+    }
+    return 0;
+}
+
+unsigned long tick_broadcast_cpumask()
+{
+    unsigned long cpumask = READ_ONCE(broadcast_cpumask);
+    WRITE_ONCE(tick_count, tick_count + 1);
+    cpumask &= ~(READ_ONCE(nohz_cpumask));
+    cpumask &= ~(1UL << SMP_ID());
+    return cpumask;
+}
+
+void tick_broadcast_enable(unsigned long cpu)
+{
+    set_bit(&broadcast_cpumask, cpu);
+}
+
 void timer_tick()
 {
+    unsigned long cpuid, kick, load;
+    struct runqueue *rq;
     struct process *current = CURRENT;
     current->runtime_counter++;
     current->tick_countdown = current->tick_countdown <= 0 ? 0 : current->tick_countdown - 1;
-    if(process_preemptable(current)) {
-        PREEMPT_DISABLE();
-        IRQ_ENABLE();
-        schedule();
-        IRQ_DISABLE();
-        PREEMPT_ENABLE();
+    if(!current->tick_countdown && current->policy != SCHED_FIFO) {
+        WRITE_ONCE(current->need_resched, 1);
+    }
+    cpuid = SMP_ID();
+    rq = &(runqueues[cpuid]);
+    SPIN_LOCK(&(rq->lock));
+    rq->ticks++;
+    load = rq->queued_weight;
+    if(current != &(rq->idle_task)) {
+        load += (1 << current->priority);
+    }
+    rq->load_avg -= rq->load_avg >> LOAD_DECAY_SHIFT;
+    rq->load_avg += (load << LOAD_SHIFT) >> LOAD_DECAY_SHIFT;
+    if(test_bit(&isolated_cpumask, cpuid)) {
+        if(!rq->nr_running && current != &(rq->idle_task) && !rq->tick_stopped) {
+            rq->tick_stopped = timer_nohz_stop();
+        }
+    }
+    else if(!--rq->balance_countdown) {
+        rq->balance_countdown = BALANCE_TICKS;
+        load_balance(rq, cpuid);
+    }
+    if(rq->nr_running) {
+        kick = find_next_bit(&nohz_cpumask, 0, NUM_CPUS);
+        if(kick < NUM_CPUS) {
+            clear_bit(&nohz_cpumask, kick);
+        }
+    }
+    SPIN_UNLOCK(&(rq->lock));
+    if(cpuid == TIMER_WHEEL_CPU) {
+        run_timers();
+    }
+    preempt_current(current);
+}
+
+static int vruntime_less(struct rbnode *a, struct rbnode *b)
+{
+    struct process *p = RB_ENTRY(a, struct process, runnode);
+    struct process *q = RB_ENTRY(b, struct process, runnode);
+    return p->vruntime < q->vruntime;
+}
+
+void wake_process(struct process *p)
+{
+    unsigned long flags;
+    int migrate = 0;
+    struct runqueue *rq = process_runqueue_lock(p, &flags);
+    WRITE_ONCE(p->state, PROCESS_STATE_RUNNING);
+    if(!p->queued && rq->current != p) {
+        if(test_bit(p->cpumask, rq - runqueues)) {
+            enqueue_process(rq, p, 0);
+            check_preempt_wakeup(rq, p);
+        }
+        else {
+            migrate_process(rq, p);
+            migrate = 1;
+        }
+    }
+    SPIN_UNLOCK_IRQRESTORE(&(rq->lock), flags);
+    if(migrate) {
+        runqueue_process(p);
     }
 }
@@ -0,0 +1,68 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cake/compiler.h"
+#include "cake/list.h"
+#include "cake/process.h"
+#include "cake/schedule.h"
+#include "cake/semaphore.h"
+#include "cake/wait.h"
+#include "arch/atomic.h"
+
+void semaphore_down(struct semaphore *semaphore)
+{
+    struct wait wait;
+    if(semaphore_down_trylock(semaphore)) {
+        return;
+    }
+    wait.sleeping = CURRENT;
+    wait.waitlist.prev = &(wait.waitlist);
+    wait.waitlist.next = &(wait.waitlist);
+    while(1) {
+        enqueue_wait(&(semaphore->waitqueue), &wait, PROCESS_STATE_UNINTERRUPTIBLE);
+        if(semaphore_down_trylock(semaphore)) {
+            break;
+        }
+        schedule_self();
+    }
+    dequeue_wait(&(semaphore->waitqueue), &wait);
+}
+
+int semaphore_down_trylock(struct semaphore *semaphore)
+{
+    unsigned long count;
+    while((count = READ_ONCE(semaphore->count))) {
+        if(CMPXCHG_ACQUIRE(&(semaphore->count), count, count - 1) == count) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void semaphore_init(struct semaphore *semaphore, unsigned long count)
+{
+    semaphore->count = count;
+    semaphore->waitqueue.waitlist.prev = &(semaphore->waitqueue.waitlist);
+    semaphore->waitqueue.waitlist.next = &(semaphore->waitqueue.waitlist);
+    semaphore->waitqueue.lock.owner = 0;
+    semaphore->waitqueue.lock.ticket = 0;
+}
+
+void semaphore_up(struct semaphore *semaphore)
+{
+    ATOMIC_LONG_ADD_RETURN(&(semaphore->count), 1);
+    if(!list_empty(&(semaphore->waitqueue.waitlist))) {
+        wake_waiter(&(semaphore->waitqueue));
+    }
+}
@@ -143,7 +143,7 @@ static int send_signal(int signo, struct siginfo *info, struct process *p)
         if(signal->flags & SIGNAL_FLAGS_STOPPED) {
             signal->flags = SIGNAL_FLAGS_CONTINUED | CHILD_CONTINUED;
         }
-        WRITE_ONCE(p->state, PROCESS_STATE_RUNNING);
+        wake_process(p);
         return 0;
     } 
     if(*(signal->pending) & SIGMASK(signo)) {
@@ -164,7 +164,7 @@ static int send_signal(int signo, struct siginfo *info, struct process *p)
     } 
     *(signal->pending) |= SIGMASK(signo);
     if(READ_ONCE(p->state) & PROCESS_STATE_INTERRUPTIBLE) {
-        WRITE_ONCE(p->state, PROCESS_STATE_RUNNING);
+        wake_process(p);
     }
     return 0;
 }
@@ -0,0 +1,190 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config/config.h"
+#include "cake/error.h"
+#include "cake/list.h"
+#include "cake/lock.h"
+#include "cake/process.h"
+#include "cake/schedule.h"
+#include "cake/signal.h"
+#include "cake/timer.h"
+#include "cake/user.h"
+#include "arch/lock.h"
+#include "arch/schedule.h"
+#include "user/time.h"
+
+struct sleeper {
+    struct timer timer;
+    struct process *sleeping;
+};
+
+static void cascade(unsigned int level);
+static void enqueue_timer(struct timer *timer);
+static void wake_sleeper(struct timer *timer);
+
+static struct list wheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SIZE];
+static unsigned long wheel_clock;
+static struct spinlock wheel_lock = {
+    .owner = 0,
+    .ticket = 0
+};
+
+void add_timer(struct timer *timer)
+{
+    unsigned long flags;
+    flags = SPIN_LOCK_IRQSAVE(&wheel_lock);
+    if(list_empty(&(timer->timerlist))) {
+        enqueue_timer(timer);
+    }
+    SPIN_UNLOCK_IRQRESTORE(&wheel_lock, flags);
+}
+
+static void cascade(unsigned int level)
+{
+    unsigned long index;
+    struct list *slot;
+    struct timer *timer;
+    index = (wheel_clock >> (level * TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK;
+    slot = &(wheel[level][index]);
+    while(!list_empty(slot)) {
+        timer = LIST_FIRST_ENTRY(slot, struct timer, timerlist);
+        list_delete_reset(&(timer->timerlist));
+        enqueue_timer(timer);
+    }
+    if(!index && level + 1 < TIMER_WHEEL_LEVELS) {
+        cascade(level + 1);
+    }
+}
+
+int del_timer(struct timer *timer)
+{
+    int pending;
+    unsigned long flags;
+    flags = SPIN_LOCK_IRQSAVE(&wheel_lock);
+    pending = !list_empty(&(timer->timerlist));
+    if(pending) {
+        list_delete_reset(&(timer->timerlist));
+    }
+    SPIN_UNLOCK_IRQRESTORE(&wheel_lock, flags);
+    return pending;
+}
+
+static void enqueue_timer(struct timer *timer)
+{
+    unsigned int level;
+    unsigned long expires, delta, index;
+    expires = timer->expires;
+    delta = expires - wheel_clock;
+    if((long) delta < 0) {
+        level = 0;
+        expires = wheel_clock;
+    }
+    else {
+        if(delta > TIMER_WHEEL_MAX_DELTA) {
+            expires = wheel_clock + TIMER_WHEEL_MAX_DELTA;
+            delta = TIMER_WHEEL_MAX_DELTA;
+        }
+        level = 0;
+        while(delta >> ((level + 1) * TIMER_WHEEL_BITS)) {
+            level++;
+        }
+    }
+    index = (expires >> (level * TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK;
+    list_enqueue(&(wheel[level][index]), &(timer->timerlist));
+}
+
+void run_timers()
+{
+    unsigned long index;
+    struct list *slot;
+    struct timer *timer;
+    SPIN_LOCK(&wheel_lock);
+    index = wheel_clock & TIMER_WHEEL_MASK;
+    if(!index) {
+        cascade(1);
+    }
+    WRITE_ONCE(wheel_clock, wheel_clock + 1);
+    slot = &(wheel[0][index]);
+    while(!list_empty(slot)) {
+        timer = LIST_FIRST_ENTRY(slot, struct timer, timerlist);
+        list_delete_reset(&(timer->timerlist));
+        timer->fn(timer);
+    }
+    SPIN_UNLOCK(&wheel_lock);
+}
+
+long schedule_timeout(long ticks)
+{
+    unsigned long expires;
+    struct sleeper sleeper;
+    expires = timer_ticks() + ticks + 1;
+    sleeper.sleeping = CURRENT;
+    sleeper.timer.expires = expires;
+    sleeper.timer.fn = wake_sleeper;
+    sleeper.timer.timerlist.prev = &(sleeper.timer.timerlist);
+    sleeper.timer.timerlist.next = &(sleeper.timer.timerlist);
+    add_timer(&(sleeper.timer));
+    schedule_self();
+    del_timer(&(sleeper.timer));
+    ticks = expires - timer_ticks();
+    return ticks < 0 ? 0 : ticks;
+}
+
+long sys_nanosleep(struct timespec *request, struct timespec *remain)
+{
+    long ticks;
+    struct timespec ts;
+    struct process *current = CURRENT;
+    copy_from_user(&ts, request, sizeof(ts));
+    if(ts.sec < 0 || ts.nsec < 0 || ts.nsec >= NSECS_PER_SEC) {
+        return -EINVAL;
+    }
+    ticks = (ts.sec * TIMER_HZ) + NSECS_TO_TICKS(ts.nsec);
+    while(ticks) {
+        SET_CURRENT_STATE(PROCESS_STATE_INTERRUPTIBLE);
+        ticks = schedule_timeout(ticks);
+        SET_CURRENT_STATE(PROCESS_STATE_RUNNING);
+        if(*(current->signal->pending) & ~(*(current->signal->blocked))) {
+            break;
+        }
+    }
+    if(remain) {
+        ts.sec = ticks / TIMER_HZ;
+        ts.nsec = TICKS_TO_NSECS(ticks);
+        copy_to_user(remain, &ts, sizeof(ts));
+    }
+    return ticks ? -EINTR : 0;
+}
+
+unsigned long timer_ticks()
+{
+    return READ_ONCE(wheel_clock);
+}
+
+void timer_wheel_init()
+{
+    for(unsigned int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for(unsigned int i = 0; i < TIMER_WHEEL_SIZE; i++) {
+            wheel[level][i].prev = &(wheel[level][i]);
+            wheel[level][i].next = &(wheel[level][i]);
+        }
+    }
+}
+
+static void wake_sleeper(struct timer *timer)
+{
+    struct sleeper *sleeper = CONTAINER_OF(timer, struct sleeper, timer);
+    wake_process(sleeper->sleeping);
+}
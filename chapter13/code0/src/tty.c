@@ -17,18 +17,22 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "config/config.h"
 #include "cake/allocate.h"
 #include "cake/bitops.h"
 #include "cake/compiler.h"
 #include "cake/error.h"
 #include "cake/file.h"
+#include "cake/mutex.h"
 #include "cake/schedule.h"
+#include "cake/timer.h"
 #include "cake/tty.h"
 #include "cake/user.h"
 #include "arch/atomic.h"
 #include "arch/barrier.h"
 #include "arch/schedule.h"
 #include "user/signal.h"
+#include "user/tty.h"
 
 #define N_TTY_BUF_SIZE      (4096)
 #define N_TTY_SIZE_MASK     (N_TTY_BUF_SIZE - 1)
@@ -261,6 +265,7 @@ static long n_tty_read(struct tty *tty, char *buffer, unsigned long count)
     unsigned long n, size, more, c, t;
     unsigned long eol, found;
     unsigned long tail;
+    long ticks;
     struct wait wait;
     struct n_tty_data *ldata = tty->disc_data;
     if((c = n_tty_check_jobctl(tty, SIGTTIN)) != 0) {
@@ -269,12 +274,19 @@ static long n_tty_read(struct tty *tty, char *buffer, unsigned long count)
     wait.sleeping = CURRENT;
     wait.waitlist.prev = &(wait.waitlist);
     wait.waitlist.next = &(wait.waitlist);
+    ticks = DIV_ROUND_UP(TTY_TIME(tty) * TIMER_HZ, 10);
     while(1) {
         enqueue_wait(&(tty->waitqueue), &wait, PROCESS_STATE_INTERRUPTIBLE);
         if(READ_ONCE(ldata->canon_head) != READ_ONCE(ldata->read_tail)) {
             break; 
         }
-        schedule_self();
+        if(!ticks) {
+            schedule_self();
+        }
+        else if(!(ticks = schedule_timeout(ticks))) {
+            dequeue_wait(&(tty->waitqueue), &wait);
+            return 0;
+        }
     }
     dequeue_wait(&(tty->waitqueue), &wait);
     n = LOAD_ACQUIRE(&(ldata->canon_head)) - ldata->read_tail;
@@ -422,6 +434,7 @@ void register_tty_driver(struct tty_driver *driver)
         tty->index = i - driver->basefile;
         tty->waitqueue.waitlist.prev = &(tty->waitqueue.waitlist);
         tty->waitqueue.waitlist.next = &(tty->waitqueue.waitlist);
+        mutex_init(&(tty->write_mutex));
         file = filesystem_file(i);
         file->ops = &tty_file_ops;
         file->extension = tty;
@@ -442,8 +455,13 @@ static int tty_close(struct file *file)
 static int tty_ioctl(struct file *file, unsigned int command, unsigned long arg)
 {
     unsigned long pid = arg;
-    struct process *p = pid_process(pid);
+    struct process *p;
     struct tty *tty = file->extension;
+    if(command == TTY_IOCTL_SET_TIME) {
+        tty->termios[TERMIOS_TIME] = arg;
+        return 0;
+    }
+    p = pid_process(pid);
     if(p) {
         XCHG_RELAXED(&(tty->pid_leader), arg);
         pid_put(pid);
@@ -489,6 +507,7 @@ static long tty_write(struct file *file, char *user, unsigned long n)
     if(!cake_buffer) {
         return -1;
     }
+    mutex_lock(&(tty->write_mutex));
     while(written < n) {
         count = n - written;
         if(count > N_TTY_BUF_SIZE) {
@@ -499,6 +518,7 @@ static long tty_write(struct file *file, char *user, unsigned long n)
         user += count;
         written += count;
     }
+    mutex_unlock(&(tty->write_mutex));
     cake_free(cake_buffer);
     return written;
 }
@@ -15,21 +15,27 @@
 #include "config/config.h"
 #include "cake/allocate.h"
 #include "cake/atomic.h"
+#include "cake/lock.h"
 #include "cake/vm.h"
+#include "arch/lock.h"
 
 extern unsigned long page_global_dir[];
 
 extern void free_user_memmap(struct memmap *mm);
+extern int migrate_user_pages(struct virtualmem *vm, struct page *page, struct page *new);
 
 struct memmap idle_memmap = {
     .users = NUM_CPUS + 1,
     .refcount = NUM_CPUS + 1,
     .pgd = page_global_dir,
     .lock = {
-        .owner = 0,
-        .ticket = 0
+        .count = 0
     }
 };
+static struct spinlock rmap_lock = {
+    .owner = 0,
+    .ticket = 0
+};
 
 void drop_memmap(struct memmap *mm)
 {
@@ -39,6 +45,39 @@ void drop_memmap(struct memmap *mm)
     }
 }
 
+int migrate_mapped_pages(struct page *page, struct page *new)
+{
+    int err = 1;
+    struct virtualmem *vm;
+    SPIN_LOCK(&rmap_lock);
+    vm = page->mapping;
+    if(page->movable && vm && !migrate_user_pages(vm, page, new)) {
+        page->mapping = 0;
+        new->mapping = vm;
+        err = 0;
+    }
+    SPIN_UNLOCK(&rmap_lock);
+    return err;
+}
+
+void page_add_mapping(struct page *page, struct virtualmem *vm)
+{
+    SPIN_LOCK(&rmap_lock);
+    if(page->movable && !page->mapping) {
+        page->mapping = vm;
+    }
+    SPIN_UNLOCK(&rmap_lock);
+}
+
+void page_remove_mapping(struct page *page, struct virtualmem *vm)
+{
+    SPIN_LOCK(&rmap_lock);
+    if(page->movable && page->mapping == vm) {
+        page->mapping = 0;
+    }
+    SPIN_UNLOCK(&rmap_lock);
+}
+
 void put_memmap(struct memmap *mm)
 {
     if(atomic_dec_and_test(&(mm->users))) {
@@ -57,10 +57,10 @@ int sys_waitpid(int pid, int *status, int options)
     wait.waitlist.prev = &(wait.waitlist);
     wait.waitlist.next = &(wait.waitlist);
     wait.sleeping = current;
-    enqueue_wait(&(current->signal->waitqueue), &wait, PROCESS_STATE_INTERRUPTIBLE);
     retval = 0;
     s = 0;
     while(1) {
+        enqueue_wait(&(current->signal->waitqueue), &wait, PROCESS_STATE_INTERRUPTIBLE);
         LIST_FOR_EACH_ENTRY(p, &(current->childlist), siblinglist) {
             SPIN_LOCK(&(p->signal->lock));
             if(p->signal->flags & SIGNAL_FLAGS_STOPPED) {
@@ -109,7 +109,7 @@ void wake_waiter(struct waitqueue *waitqueue)
         wait = LIST_FIRST_ENTRY(&(waitqueue->waitlist), struct wait, waitlist);
         list_delete_reset(&(wait->waitlist));
         SMP_MB();
-        WRITE_ONCE(wait->sleeping->state, PROCESS_STATE_RUNNING);
+        wake_process(wait->sleeping);
     }
     SPIN_UNLOCK(&(waitqueue->lock));
 }
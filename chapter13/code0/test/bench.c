@@ -0,0 +1,128 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config/config.h"
+#include "cake/allocate.h"
+#include "cake/bitops.h"
+#include "arch/page.h"
+#include "host.h"
+
+#define BENCH_BATCH     (16)
+#define BENCH_BITS      (4096)
+#define BENCH_ROUNDS    (20000)
+
+struct bench_pages {
+    unsigned int order;
+};
+
+struct bench_objects {
+    unsigned long minsize;
+    unsigned long maxsize;
+};
+
+static unsigned long bitmap[BITS_TO_LONGS(BENCH_BITS)];
+
+static void bench_bitmap_search()
+{
+    unsigned long start, bit, found = 0;
+    bitmap_zero(bitmap, BENCH_BITS);
+    for(bit = 0; bit < BENCH_BITS; bit += 97) {
+        set_bit(bitmap, bit);
+    }
+    start = host_nanoseconds();
+    for(unsigned long i = 0; i < BENCH_ROUNDS; i++) {
+        bit = find_next_bit(bitmap, 0, BENCH_BITS);
+        while(bit < BENCH_BITS) {
+            found++;
+            bit = find_next_bit(bitmap, bit + 1, BENCH_BITS);
+        }
+    }
+    host_bench("bitmap find_next_bit", found, host_nanoseconds() - start);
+    ASSERT(found == BENCH_ROUNDS * DIV_ROUND_UP(BENCH_BITS, 97));
+    start = host_nanoseconds();
+    for(unsigned long i = 0; i < BENCH_ROUNDS; i++) {
+        bit = find_next_zero_bit(bitmap, 0, BENCH_BITS);
+        while(bit < BENCH_BITS) {
+            found++;
+            bit = find_next_zero_bit(bitmap, bit + 1, BENCH_BITS);
+        }
+    }
+    host_bench("bitmap find_next_zero_bit", found, host_nanoseconds() - start);
+}
+
+static void bench_objects_cpu(unsigned long cpu, void *arg)
+{
+    struct bench_objects *bench = arg;
+    unsigned long size = bench->minsize;
+    void *objs[BENCH_BATCH];
+    for(unsigned long i = 0; i < BENCH_ROUNDS; i++) {
+        for(unsigned int j = 0; j < BENCH_BATCH; j++) {
+            objs[j] = cake_alloc(size);
+            ASSERT(objs[j]);
+            size = size << 1 > bench->maxsize ? bench->minsize : size << 1;
+        }
+        for(unsigned int j = 0; j < BENCH_BATCH; j++) {
+            cake_free(objs[j]);
+        }
+    }
+}
+
+static void bench_objects(const char *name, unsigned long minsize, unsigned long maxsize)
+{
+    unsigned long start;
+    struct bench_objects bench = {
+        .minsize = minsize,
+        .maxsize = maxsize
+    };
+    start = host_nanoseconds();
+    host_run_cpus(bench_objects_cpu, &bench);
+    host_bench(name, NUM_CPUS * BENCH_ROUNDS * BENCH_BATCH * 2, host_nanoseconds() - start);
+}
+
+static void bench_pages_cpu(unsigned long cpu, void *arg)
+{
+    struct bench_pages *bench = arg;
+    struct page *pages[BENCH_BATCH];
+    for(unsigned long i = 0; i < BENCH_ROUNDS; i++) {
+        for(unsigned int j = 0; j < BENCH_BATCH; j++) {
+            pages[j] = alloc_pages(bench->order);
+            ASSERT(pages[j]);
+        }
+        for(unsigned int j = 0; j < BENCH_BATCH; j++) {
+            free_pages(pages[j]);
+        }
+    }
+}
+
+static void bench_pages(const char *name, unsigned int order)
+{
+    unsigned long start;
+    struct bench_pages bench = {
+        .order = order
+    };
+    start = host_nanoseconds();
+    host_run_cpus(bench_pages_cpu, &bench);
+    host_bench(name, NUM_CPUS * BENCH_ROUNDS * BENCH_BATCH * 2, host_nanoseconds() - start);
+}
+
+int main()
+{
+    host_init();
+    bench_pages("alloc/free pages order 0", 0);
+    bench_pages("alloc/free pages order 4", 4);
+    bench_objects("cake_alloc/free 64", 64, 64);
+    bench_objects("cake_alloc/free 32-4096 mix", 32, 4096);
+    bench_bitmap_search();
+    return 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cake/bitops.h"
+#include "host.h"
+
+#define TEST_BITS   (1000)
+
+static unsigned long bitmap[BITS_TO_LONGS(TEST_BITS)];
+
+static void test_find_next_bit()
+{
+    bitmap_zero(bitmap, TEST_BITS);
+    ASSERT(find_next_bit(bitmap, 0, TEST_BITS) == TEST_BITS);
+    ASSERT(find_next_zero_bit(bitmap, 0, TEST_BITS) == 0);
+    set_bit(bitmap, 0);
+    set_bit(bitmap, 63);
+    set_bit(bitmap, 64);
+    set_bit(bitmap, 999);
+    ASSERT(find_next_bit(bitmap, 0, TEST_BITS) == 0);
+    ASSERT(find_next_bit(bitmap, 1, TEST_BITS) == 63);
+    ASSERT(find_next_bit(bitmap, 64, TEST_BITS) == 64);
+    ASSERT(find_next_bit(bitmap, 65, TEST_BITS) == 999);
+    ASSERT(find_next_bit(bitmap, 65, 999) == 999);
+    ASSERT(find_next_bit(bitmap, 65, 998) == 998);
+    ASSERT(find_next_bit(bitmap, TEST_BITS, TEST_BITS) == TEST_BITS);
+    ASSERT(find_next_zero_bit(bitmap, 0, TEST_BITS) == 1);
+    ASSERT(find_next_zero_bit(bitmap, 63, TEST_BITS) == 65);
+    bitmap_fill(bitmap, TEST_BITS);
+    ASSERT(find_next_zero_bit(bitmap, 0, TEST_BITS) == TEST_BITS);
+    clear_bit(bitmap, 500);
+    ASSERT(find_next_zero_bit(bitmap, 0, TEST_BITS) == 500);
+    ASSERT(find_next_zero_bit(bitmap, 501, TEST_BITS) == TEST_BITS);
+    host_pass("find_next_bit");
+}
+
+static void test_set_clear_bit()
+{
+    bitmap_zero(bitmap, TEST_BITS);
+    for(unsigned long i = 0; i < TEST_BITS; i += 3) {
+        ASSERT(!test_and_set_bit(bitmap, i));
+        ASSERT(test_and_set_bit(bitmap, i));
+    }
+    for(unsigned long i = 0; i < TEST_BITS; i++) {
+        ASSERT(test_bit(bitmap, i) == !(i % 3));
+    }
+    for(unsigned long i = 0; i < TEST_BITS; i += 3) {
+        ASSERT(test_and_clear_bit(bitmap, i));
+        ASSERT(!test_and_clear_bit(bitmap, i));
+    }
+    ASSERT(find_next_bit(bitmap, 0, TEST_BITS) == TEST_BITS);
+    host_pass("test_and_set_bit");
+}
+
+int main()
+{
+    test_find_next_bit();
+    test_set_clear_bit();
+    return 0;
+}
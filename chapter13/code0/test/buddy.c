@@ -0,0 +1,186 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config/config.h"
+#include "cake/allocate.h"
+#include "arch/page.h"
+#include "host.h"
+
+#define COMPACT_ORDER   (4)
+#define MAX_BLOCKS      (HOST_MEMORY_SIZE >> PAGE_SHIFT)
+#define PAGEBLOCK_PAGES (1UL << (MAX_ORDER))
+
+static struct page *blocks[MAX_BLOCKS];
+static struct page *movable[PAGEBLOCK_PAGES];
+static unsigned long mapping;
+
+static unsigned long alloc_all(unsigned int order)
+{
+    unsigned long n = 0;
+    while(n < MAX_BLOCKS && (blocks[n] = alloc_pages(order))) {
+        n++;
+    }
+    return n;
+}
+
+static void free_all(unsigned long n)
+{
+    while(n--) {
+        free_pages(blocks[n]);
+    }
+}
+
+static void test_buddy_coalesce()
+{
+    unsigned long large, small, again;
+    large = alloc_all(MAX_ORDER);
+    ASSERT(large > 0);
+    for(unsigned long i = 0; i < large; i++) {
+        ASSERT(blocks[i]->pfn < (MAX_BLOCKS - CONTIG_REGION_PAGES));
+        for(unsigned long j = 0; j < i; j++) {
+            ASSERT(blocks[i]->pfn != blocks[j]->pfn);
+        }
+    }
+    free_all(large);
+    small = alloc_all(0);
+    ASSERT(small >= (large << MAX_ORDER));
+    free_all(small);
+    again = alloc_all(MAX_ORDER);
+    ASSERT(again == large);
+    free_all(again);
+    host_pass("buddy coalesce");
+}
+
+static void test_buddy_compact()
+{
+    unsigned long n, pageblock;
+    struct page *page;
+    for(unsigned long i = 0; i < PAGEBLOCK_PAGES; i++) {
+        movable[i] = alloc_pages_movable(0);
+        ASSERT(movable[i]);
+        ASSERT((movable[i]->pfn >> MAX_ORDER) == (movable[0]->pfn >> MAX_ORDER));
+        movable[i]->mapping = (struct virtualmem *) &mapping;
+    }
+    n = alloc_all(COMPACT_ORDER);
+    ASSERT(n > 32);
+    for(unsigned long i = 1; i < n; i += 2) {
+        free_pages(blocks[i]);
+    }
+    for(unsigned long i = 1; i < PAGEBLOCK_PAGES; i += 2) {
+        free_pages(movable[i]);
+    }
+    ASSERT(!alloc_pages_movable(MAX_ORDER));
+    for(unsigned long i = 0; i < PAGEBLOCK_PAGES; i += 2) {
+        ASSERT(movable[i]->mapping == (struct virtualmem *) &mapping);
+    }
+    pageblock = blocks[n - 2]->pfn >> MAX_ORDER;
+    for(unsigned long i = 0; i < n; i += 2) {
+        if((blocks[i]->pfn >> MAX_ORDER) == pageblock) {
+            free_pages(blocks[i]);
+        }
+    }
+    for(unsigned long i = 1; i < PAGEBLOCK_PAGES; i += 2) {
+        movable[i] = alloc_pages_movable(0);
+        ASSERT(movable[i]);
+    }
+    page = alloc_pages_movable(0);
+    ASSERT(page);
+    ASSERT((page->pfn >> MAX_ORDER) == pageblock);
+    for(unsigned long i = 1; i < PAGEBLOCK_PAGES; i += 2) {
+        free_pages(movable[i]);
+    }
+    page = alloc_pages_movable(MAX_ORDER);
+    ASSERT(page);
+    for(unsigned long i = 0; i < PAGEBLOCK_PAGES; i += 2) {
+        ASSERT(!movable[i]->mapping);
+    }
+    host_pass("buddy compact");
+}
+
+static void test_buddy_movable()
+{
+    struct page *page = alloc_pages_movable(1);
+    ASSERT(page);
+    ASSERT(page->movable);
+    ASSERT(page->refcount == 1);
+    ASSERT(GLOBAL_MEMMAP[page->pfn & ~((1UL << MAX_ORDER) - 1)].migratetype == MIGRATE_MOVABLE);
+    free_pages(page);
+    ASSERT(!page->movable);
+    ASSERT(alloc_pages_bulk_movable(1, 8, blocks) == 8);
+    for(unsigned long i = 0; i < 8; i++) {
+        ASSERT(blocks[i]->movable);
+        ASSERT(blocks[i]->refcount == 1);
+        ASSERT(!blocks[i]->mapping);
+        ASSERT(GLOBAL_MEMMAP[blocks[i]->pfn & ~((1UL << MAX_ORDER) - 1)].migratetype ==
+            MIGRATE_MOVABLE);
+    }
+    free_pages_bulk(blocks, 8);
+    host_pass("buddy movable");
+}
+
+static void test_buddy_orders()
+{
+    struct page *page;
+    unsigned char *bytes;
+    for(unsigned int order = 0; order <= MAX_ORDER; order++) {
+        page = alloc_pages(order);
+        ASSERT(page);
+        ASSERT(!(page->pfn & ((1UL << order) - 1)));
+        ASSERT(page->refcount == 1);
+        ASSERT(page->current_order == order);
+        for(unsigned long i = 0; i < (1UL << order); i++) {
+            ASSERT(GLOBAL_MEMMAP[page->pfn + i].allocated);
+        }
+        bytes = PAGE_TO_PTR(page);
+        for(unsigned long i = 0; i < (PAGE_SIZE << order); i += 64) {
+            bytes[i] = order;
+        }
+        free_pages(page);
+    }
+    host_pass("buddy orders");
+}
+
+static void test_buddy_zeroed()
+{
+    struct page *page;
+    unsigned char *bytes;
+    page = alloc_pages(2);
+    ASSERT(page);
+    bytes = PAGE_TO_PTR(page);
+    for(unsigned long i = 0; i < (PAGE_SIZE << 2); i++) {
+        bytes[i] = 0xA5;
+    }
+    free_pages(page);
+    for(unsigned int i = 0; i < 8; i++) {
+        page = alloc_pages_zeroed(2);
+        ASSERT(page);
+        bytes = PAGE_TO_PTR(page);
+        for(unsigned long j = 0; j < (PAGE_SIZE << 2); j++) {
+            ASSERT(!bytes[j]);
+        }
+        free_pages(page);
+    }
+    host_pass("buddy zeroed");
+}
+
+int main()
+{
+    host_init();
+    test_buddy_orders();
+    test_buddy_zeroed();
+    test_buddy_movable();
+    test_buddy_coalesce();
+    test_buddy_compact();
+    return 0;
+}
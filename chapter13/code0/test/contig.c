@@ -0,0 +1,99 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config/config.h"
+#include "cake/allocate.h"
+#include "arch/page.h"
+#include "host.h"
+
+#define CONTIG_ORDER    ((MAX_ORDER) + 1)
+#define CONTIG_RUNS     ((CONTIG_REGION_PAGES) >> (CONTIG_ORDER))
+#define CONTIG_START    (((HOST_MEMORY_SIZE) >> (PAGE_SHIFT)) - (CONTIG_REGION_PAGES))
+
+static struct page *runs[CONTIG_RUNS + 1];
+
+static int page_is_contig(struct page *page)
+{
+    return page->pfn >= CONTIG_START && page->pfn < CONTIG_START + CONTIG_REGION_PAGES;
+}
+
+static void test_contig_bulk()
+{
+    ASSERT(alloc_pages_bulk(CONTIG_ORDER, CONTIG_RUNS, runs) == CONTIG_RUNS);
+    for(unsigned int i = 0; i < CONTIG_RUNS; i++) {
+        ASSERT(page_is_contig(runs[i]));
+        ASSERT(runs[i]->refcount == 1);
+    }
+    ASSERT(!alloc_pages_bulk(CONTIG_ORDER, 1, &(runs[CONTIG_RUNS])));
+    free_pages_bulk(runs, CONTIG_RUNS);
+    ASSERT(alloc_pages_bulk(CONTIG_ORDER, CONTIG_RUNS, runs) == CONTIG_RUNS);
+    free_pages_bulk(runs, CONTIG_RUNS);
+    host_pass("contig bulk");
+}
+
+static void test_contig_cake_alloc()
+{
+    unsigned long size = (3UL << 20) + 1;
+    unsigned char *bytes = cake_alloc(size);
+    struct page *page;
+    ASSERT(bytes);
+    page = &(PTR_TO_PAGE(bytes));
+    ASSERT(page_is_contig(page));
+    ASSERT(!page->cache);
+    for(unsigned long i = 0; i < size; i += 64) {
+        bytes[i] = i;
+    }
+    cake_free(bytes);
+    page = alloc_contig_pages(CONTIG_REGION_PAGES);
+    ASSERT(page);
+    ASSERT(page->pfn == CONTIG_START);
+    free_pages(page);
+    host_pass("contig cake_alloc");
+}
+
+static void test_contig_pages()
+{
+    unsigned int n = 0;
+    while(n <= CONTIG_RUNS && (runs[n] = alloc_pages(CONTIG_ORDER))) {
+        ASSERT(page_is_contig(runs[n]));
+        ASSERT(!((runs[n]->pfn - CONTIG_START) & ((1UL << MAX_ORDER) - 1)));
+        for(unsigned int i = 0; i < n; i++) {
+            ASSERT(runs[n]->pfn != runs[i]->pfn);
+        }
+        n++;
+    }
+    ASSERT(n == CONTIG_RUNS);
+    ASSERT(!alloc_contig_pages(1));
+    free_pages(runs[1]);
+    ASSERT(!alloc_contig_pages((1UL << CONTIG_ORDER) + 1));
+    runs[1] = alloc_contig_pages(1UL << CONTIG_ORDER);
+    ASSERT(runs[1]);
+    while(n--) {
+        free_pages(runs[n]);
+    }
+    ASSERT(alloc_contig_pages(CONTIG_REGION_PAGES + 1) == 0);
+    runs[0] = alloc_contig_pages(CONTIG_REGION_PAGES);
+    ASSERT(runs[0]);
+    free_pages(runs[0]);
+    host_pass("contig pages");
+}
+
+int main()
+{
+    host_init();
+    test_contig_pages();
+    test_contig_cake_alloc();
+    test_contig_bulk();
+    return 0;
+}
@@ -0,0 +1,180 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "config/config.h"
+#include "cake/allocate.h"
+#include "cake/list.h"
+#include "cake/process.h"
+#include "arch/page.h"
+#include "host.h"
+
+struct host_cpu {
+    unsigned long cpu;
+    void (*fn)(unsigned long cpu, void *arg);
+    void *arg;
+};
+
+extern void allocate_init();
+
+static void *host_cpu_entry(void *arg);
+
+static __thread unsigned long host_cpu_id;
+static __thread struct process host_current;
+unsigned long host_freed_processes;
+unsigned long host_memory_base;
+
+unsigned long arch_populate_allocate_structures(struct list *freelists,
+    struct contigregion *contig)
+{
+    struct page *p;
+    unsigned long numpages = HOST_MEMORY_SIZE >> PAGE_SHIFT;
+    unsigned long contigstart = numpages - CONTIG_REGION_PAGES;
+    host_memory_base = (unsigned long) aligned_alloc(PAGE_SIZE << MAX_ORDER, HOST_MEMORY_SIZE);
+    GLOBAL_MEMMAP = calloc(numpages, sizeof(struct page));
+    if(!host_memory_base || !GLOBAL_MEMMAP) {
+        host_fail(__FILE__, __LINE__, "host memory");
+    }
+    for(unsigned long pfn = 0; pfn < numpages; pfn++) {
+        p = &(GLOBAL_MEMMAP[pfn]);
+        p->pfn = pfn;
+        p->migratetype = MIGRATE_UNMOVABLE;
+        if(pfn >= contigstart) {
+            p->allocated = 1;
+            p->reserved = 1;
+            p->valid = 1;
+        }
+        else if(!(pfn & ((1UL << MAX_ORDER) - 1))) {
+            p->valid = 1;
+            p->current_order = MAX_ORDER;
+            p->original_order = MAX_ORDER;
+            list_enqueue(&(freelists[MAX_ORDER]), &(p->pagelist));
+        }
+    }
+    contig->startpfn = contigstart;
+    contig->numpages = CONTIG_REGION_PAGES;
+    contig->freepages = CONTIG_REGION_PAGES;
+    return numpages;
+}
+
+struct process *__current()
+{
+    return &host_current;
+}
+
+unsigned long __smp_id()
+{
+    return host_cpu_id;
+}
+
+unsigned long __timer_count()
+{
+    return host_nanoseconds();
+}
+
+unsigned long __timer_frequency()
+{
+    return 1000000000UL;
+}
+
+void __zero_dcache_range(void *va, unsigned long size)
+{
+    __builtin_memset(va, 0, size);
+}
+
+void free_process(struct process *p)
+{
+    __atomic_fetch_add(&host_freed_processes, 1, __ATOMIC_RELAXED);
+}
+
+void host_bench(const char *name, unsigned long ops, unsigned long nanoseconds)
+{
+    printf("%-32s %12lu ops/sec\n", name,
+        nanoseconds ? (unsigned long) ((ops * 1000000000.0) / nanoseconds) : 0);
+    fflush(stdout);
+}
+
+static void *host_cpu_entry(void *arg)
+{
+    struct host_cpu *cpu = arg;
+    host_cpu_id = cpu->cpu;
+    cpu->fn(cpu->cpu, cpu->arg);
+    return 0;
+}
+
+void host_fail(const char *file, int line, const char *cond)
+{
+    printf("FAIL %s:%d: %s\n", file, line, cond);
+    exit(1);
+}
+
+void host_init()
+{
+    allocate_init();
+}
+
+unsigned long host_nanoseconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1000000000UL) + ts.tv_nsec;
+}
+
+void host_pass(const char *name)
+{
+    printf("PASS %s\n", name);
+    fflush(stdout);
+}
+
+void host_run_cpus(void (*fn)(unsigned long cpu, void *arg), void *arg)
+{
+    pthread_t threads[NUM_CPUS];
+    struct host_cpu cpus[NUM_CPUS];
+    for(unsigned long i = 0; i < NUM_CPUS; i++) {
+        cpus[i].cpu = i;
+        cpus[i].fn = fn;
+        cpus[i].arg = arg;
+        if(pthread_create(&(threads[i]), 0, host_cpu_entry, &(cpus[i]))) {
+            host_fail(__FILE__, __LINE__, "pthread_create");
+        }
+    }
+    for(unsigned long i = 0; i < NUM_CPUS; i++) {
+        pthread_join(threads[i], 0);
+    }
+}
+
+void host_wait_event()
+{
+    sched_yield();
+}
+
+int migrate_mapped_pages(struct page *page, struct page *new)
+{
+    if(!page->mapping) {
+        return 1;
+    }
+    __builtin_memcpy(PAGE_TO_PTR(new), PAGE_TO_PTR(page), PAGE_SIZE << page->current_order);
+    new->mapping = page->mapping;
+    page->mapping = 0;
+    return 0;
+}
+
+void preempt_schedule()
+{
+}
@@ -0,0 +1,39 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TEST_HOST_H
+#define _TEST_HOST_H
+
+#define HOST_MEMORY_SHIFT   (26)
+#define HOST_MEMORY_SIZE    (1UL << (HOST_MEMORY_SHIFT))
+
+#define ASSERT(cond)        do { \
+                                if(!(cond)) { \
+                                    host_fail(__FILE__, __LINE__, #cond); \
+                                } \
+                            } while(0)
+
+struct process;
+
+extern unsigned long host_freed_processes;
+
+void host_bench(const char *name, unsigned long ops, unsigned long nanoseconds);
+void host_fail(const char *file, int line, const char *cond);
+void host_init();
+unsigned long host_nanoseconds();
+void host_pass(const char *name);
+void host_run_cpus(void (*fn)(unsigned long cpu, void *arg), void *arg);
+void host_wait_event();
+
+#endif
@@ -0,0 +1,49 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _ARCH_BARRIER_H
+#define _ARCH_BARRIER_H
+
+#define SEV()                       asm volatile("" : : : "memory")
+#define WFE()                       host_wait_event()
+#define WFI()                       host_wait_event()
+
+#define ISB()                       asm volatile("" : : : "memory")
+#define DMB(opt)                    __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define DSB(opt)                    __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#define SYS_MB()                    DSB(sy)
+#define SYS_RMB()                   DSB(ld)
+#define SYS_WMB()                   DSB(st)
+
+#define SMP_MB()                    DMB(ish)
+#define SMP_RMB()                   DMB(ishld)
+#define SMP_WMB()                   DMB(ishst)
+
+#define LOAD_ACQUIRE(ptr)           __load_acquire(ptr)
+#define STORE_RELEASE(ptr, val)     __store_release(ptr, val)
+
+void host_wait_event();
+
+static inline unsigned long __load_acquire(void *src)
+{
+    return __atomic_load_n((volatile unsigned long *) src, __ATOMIC_ACQUIRE);
+}
+
+static inline void __store_release(void *dest, unsigned long val)
+{
+    __atomic_store_n((volatile unsigned long *) dest, val, __ATOMIC_RELEASE);
+}
+
+#endif
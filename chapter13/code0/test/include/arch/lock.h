@@ -0,0 +1,186 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _ARCH_LOCK_H
+#define _ARCH_LOCK_H
+
+#include "config/config.h"
+#include "cake/lock.h"
+#include "cake/schedule.h"
+#include "arch/barrier.h"
+
+#define READ_LOCK               read_lock
+#define READ_UNLOCK             read_unlock
+#define SPIN_LOCK               spin_lock
+#define SPIN_LOCK_IRQSAVE       spin_lock_irqsave
+#define SPIN_TRYLOCK            spin_trylock
+#define SPIN_TRYLOCK_IRQSAVE    spin_trylock_irqsave
+#define SPIN_UNLOCK             spin_unlock
+#define SPIN_UNLOCK_IRQRESTORE  spin_unlock_irqrestore
+#define SPIN_LOCK_BOOT          __spin_lock
+#define SPIN_UNLOCK_BOOT        __spin_unlock
+#define WRITE_LOCK              write_lock
+#define WRITE_LOCK_IRQSAVE      write_lock_irqsave
+#define WRITE_TRYLOCK_IRQSAVE   write_trylock_irqsave
+#define WRITE_UNLOCK            write_unlock
+#define WRITE_UNLOCK_IRQRESTORE write_unlock_irqrestore
+
+#define RWLOCK_WRITER           (0x80000000)
+
+static inline void __read_lock(struct rwlock *lock)
+{
+    unsigned int count;
+    while(1) {
+        count = __atomic_load_n(&(lock->count), __ATOMIC_RELAXED);
+        if(!(count & RWLOCK_WRITER) && __atomic_compare_exchange_n(&(lock->count),
+            &count, count + 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return;
+        }
+        WFE();
+    }
+}
+
+static inline void __read_unlock(struct rwlock *lock)
+{
+    __atomic_fetch_sub(&(lock->count), 1, __ATOMIC_RELEASE);
+}
+
+static inline void __spin_lock(struct spinlock *lock)
+{
+    unsigned int ticket = __atomic_fetch_add(&(lock->ticket), 1, __ATOMIC_RELAXED);
+    while(__atomic_load_n(&(lock->owner), __ATOMIC_ACQUIRE) != ticket) {
+        WFE();
+    }
+}
+
+static inline int __spin_trylock(struct spinlock *lock)
+{
+    unsigned int owner = __atomic_load_n(&(lock->owner), __ATOMIC_RELAXED);
+    return __atomic_compare_exchange_n(&(lock->ticket), &owner, owner + 1, 0,
+        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static inline void __spin_unlock(struct spinlock *lock)
+{
+    __atomic_store_n(&(lock->owner), lock->owner + 1, __ATOMIC_RELEASE);
+}
+
+static inline void __write_lock(struct rwlock *lock)
+{
+    unsigned int count = 0;
+    while(!__atomic_compare_exchange_n(&(lock->count), &count, RWLOCK_WRITER, 0,
+        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        count = 0;
+        WFE();
+    }
+}
+
+static inline int __write_trylock(struct rwlock *lock)
+{
+    unsigned int count = 0;
+    return __atomic_compare_exchange_n(&(lock->count), &count, RWLOCK_WRITER, 0,
+        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static inline void __write_unlock(struct rwlock *lock)
+{
+    __atomic_store_n(&(lock->count), 0, __ATOMIC_RELEASE);
+}
+
+static inline void read_lock(struct rwlock *lock)
+{
+    PREEMPT_DISABLE();
+    __read_lock(lock);
+}
+
+static inline void read_unlock(struct rwlock *lock)
+{
+    __read_unlock(lock);
+    PREEMPT_ENABLE();
+}
+
+static inline void spin_lock(struct spinlock *lock)
+{
+    PREEMPT_DISABLE();
+    __spin_lock(lock);
+}
+
+static inline unsigned long spin_lock_irqsave(struct spinlock *lock)
+{
+    spin_lock(lock);
+    return 0;
+}
+
+static inline int spin_trylock(struct spinlock *lock)
+{
+    PREEMPT_DISABLE();
+    if(__spin_trylock(lock)) {
+        return 1;
+    }
+    PREEMPT_ENABLE();
+    return 0;
+}
+
+static inline int spin_trylock_irqsave(struct spinlock *lock, unsigned long *flags)
+{
+    *flags = 0;
+    return spin_trylock(lock);
+}
+
+static inline void spin_unlock(struct spinlock *lock)
+{
+    __spin_unlock(lock);
+    PREEMPT_ENABLE();
+}
+
+static inline void spin_unlock_irqrestore(struct spinlock *lock, unsigned long flags)
+{
+    spin_unlock(lock);
+}
+
+static inline void write_lock(struct rwlock *lock)
+{
+    PREEMPT_DISABLE();
+    __write_lock(lock);
+}
+
+static inline unsigned long write_lock_irqsave(struct rwlock *lock)
+{
+    write_lock(lock);
+    return 0;
+}
+
+static inline int write_trylock_irqsave(struct rwlock *lock, unsigned long *flags)
+{
+    *flags = 0;
+    PREEMPT_DISABLE();
+    if(__write_trylock(lock)) {
+        return 1;
+    }
+    PREEMPT_ENABLE();
+    return 0;
+}
+
+static inline void write_unlock(struct rwlock *lock)
+{
+    __write_unlock(lock);
+    PREEMPT_ENABLE();
+}
+
+static inline void write_unlock_irqrestore(struct rwlock *lock, unsigned long flags)
+{
+    write_unlock(lock);
+}
+
+#endif
@@ -0,0 +1,27 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _ARCH_TIMER_H
+#define _ARCH_TIMER_H
+
+#define TIMER_COUNT     __timer_count
+#define TIMER_FREQUENCY __timer_frequency
+
+#define TIMER_CTL_ENABLE    (0b001)
+#define TIMER_CTL_IMASK     (0b010)
+
+unsigned long __timer_count();
+unsigned long __timer_frequency();
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config/config.h"
+#include "cake/allocate.h"
+#include "cake/process.h"
+#include "host.h"
+
+#define TEST_PIDS   (100)
+
+extern unsigned long allocate_pid(struct process *p);
+extern void pid_init();
+extern struct process *pid_process(unsigned int pid);
+extern void pid_put(unsigned int pid);
+
+static struct process processes[TEST_PIDS];
+static unsigned long pids[TEST_PIDS];
+
+static void test_pid_allocate()
+{
+    for(unsigned long i = 0; i < TEST_PIDS; i++) {
+        pids[i] = allocate_pid(&(processes[i]));
+        ASSERT(pids[i] >= NUM_CPUS);
+        ASSERT(processes[i].refcount == 1);
+        for(unsigned long j = 0; j < i; j++) {
+            ASSERT(pids[i] != pids[j]);
+        }
+    }
+    for(unsigned long i = 0; i < TEST_PIDS; i++) {
+        ASSERT(pid_process(pids[i]) == &(processes[i]));
+        pid_put(pids[i]);
+    }
+    ASSERT(!host_freed_processes);
+    host_pass("pid allocate");
+}
+
+static void test_pid_put()
+{
+    for(unsigned long i = 0; i < TEST_PIDS; i++) {
+        pid_put(pids[i]);
+        ASSERT(host_freed_processes == i + 1);
+        ASSERT(!pid_process(pids[i]));
+    }
+    host_pass("pid put");
+}
+
+static void test_pid_reuse()
+{
+    unsigned long pid;
+    for(unsigned long i = 0; i < (1UL << 12); i++) {
+        pid = allocate_pid(&(processes[0]));
+        ASSERT(pid >= NUM_CPUS);
+        ASSERT(pid_process(pid) == &(processes[0]));
+        pid_put(pid);
+        pid_put(pid);
+        ASSERT(!pid_process(pid));
+    }
+    host_pass("pid reuse");
+}
+
+int main()
+{
+    host_init();
+    pid_init();
+    test_pid_allocate();
+    test_pid_put();
+    test_pid_reuse();
+    return 0;
+}
@@ -0,0 +1,206 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config/config.h"
+#include "cake/allocate.h"
+#include "arch/page.h"
+#include "host.h"
+
+#define SHRINK_OBJSIZE  (2048)
+#define TEST_OBJECTS    (1000)
+#define TEST_OBJSIZE    (48)
+#define CPU_OBJECTS     (200)
+#define CPU_ROUNDS      (500)
+#define OBJ_CACHE(ptr)  ((&(PTR_TO_PAGE(ptr)))->cache)
+
+static unsigned long constructed;
+static void *objects[TEST_OBJECTS];
+static struct cache *test_cache;
+
+static void test_ctor(void *obj)
+{
+    *((unsigned long *) obj) = 0xC0FFEE;
+    constructed++;
+}
+
+static unsigned long cache_free_objects(struct cache *cache)
+{
+    unsigned long free = cache->freecount;
+    for(unsigned int i = 0; i < NUM_CPUS; i++) {
+        free += cache->cpucaches[i]->free;
+    }
+    return free;
+}
+
+static unsigned int size_class(unsigned long size)
+{
+    unsigned int index = 0;
+    while(index < NUM_SIZE_CACHES && size > (1UL << (index + MIN_SIZE_CACHE_ORDER))) {
+        index++;
+    }
+    return index;
+}
+
+static void test_cake_alloc()
+{
+    unsigned long sizes[] = {1, 8, 31, 32, 33, 100, 512, 513, 4095, 4096, 4097, 65536, 1UL << 20};
+    unsigned long *obj;
+    struct cache *cache;
+    for(unsigned int i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+        obj = cake_alloc(sizes[i]);
+        ASSERT(obj);
+        cache = OBJ_CACHE(obj);
+        if(cache) {
+            ASSERT(cache->objsize >= sizes[i]);
+        }
+        else {
+            ASSERT((PAGE_SIZE << PTR_TO_PAGE(obj).current_order) >= sizes[i]);
+        }
+        obj[(sizes[i] - 1) / sizeof(*obj)] = sizes[i];
+        cake_free(obj);
+    }
+    obj = cake_alloc((1UL << 20) + 1);
+    ASSERT(obj);
+    ASSERT(!OBJ_CACHE(obj));
+    ASSERT(!(((unsigned long) obj) & (PAGE_SIZE - 1)));
+    cake_free(obj);
+    host_pass("slab cake_alloc");
+}
+
+static void test_cake_alloc_index()
+{
+    unsigned long sizes[] = {0, 1, 31, 32, 33, 63, 64, 65, 4095, 4096, 4097,
+        (1UL << 19) + 1, (1UL << 20) - 1, 1UL << 20, (1UL << 20) + 1};
+    unsigned long *obj;
+    struct cache *cache;
+    unsigned int index;
+    for(unsigned int i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+        index = size_class(sizes[i]);
+        obj = cake_alloc(sizes[i]);
+        ASSERT(obj);
+        cache = OBJ_CACHE(obj);
+        if(index < NUM_SIZE_CACHES) {
+            ASSERT(cache);
+            ASSERT(cache->objsize == (1UL << (index + MIN_SIZE_CACHE_ORDER)));
+        }
+        else {
+            ASSERT(!cache);
+        }
+        cake_free(obj);
+    }
+    host_pass("slab cake_alloc index");
+}
+
+static unsigned long free_slabs(struct cache *cache)
+{
+    unsigned long n = 0;
+    struct slab *slab;
+    LIST_FOR_EACH_ENTRY(slab, &(cache->slabsfree), slablist) {
+        n++;
+    }
+    return n;
+}
+
+static void test_slab_shrink()
+{
+    struct page *page, *pages = 0;
+    struct cache *cache;
+    for(unsigned long i = 0; i < TEST_OBJECTS; i++) {
+        objects[i] = cake_alloc(SHRINK_OBJSIZE);
+        ASSERT(objects[i]);
+    }
+    cache = OBJ_CACHE(objects[0]);
+    ASSERT(cache->objsize > ONSLAB_DESCRIPTOR_SIZE);
+    for(unsigned long i = 0; i < TEST_OBJECTS; i++) {
+        cake_free(objects[i]);
+    }
+    ASSERT(free_slabs(cache) > SLABSFREE_RESERVE);
+    while((page = alloc_pages(MAX_ORDER))) {
+        *((struct page **) PAGE_TO_PTR(page)) = pages;
+        pages = page;
+    }
+    while(pages) {
+        page = pages;
+        pages = *((struct page **) PAGE_TO_PTR(page));
+        free_pages(page);
+    }
+    ASSERT(free_slabs(cache) > SLABSFREE_RESERVE);
+    drain_idle_cpucaches();
+    ASSERT(free_slabs(cache) <= SLABSFREE_RESERVE);
+    host_pass("slab shrink");
+}
+
+static void test_slab_objects()
+{
+    unsigned long *obj;
+    test_cache = alloc_cache_ctor("test", TEST_OBJSIZE, test_ctor, 0);
+    ASSERT(test_cache);
+    for(unsigned long i = 0; i < TEST_OBJECTS; i++) {
+        obj = alloc_obj(test_cache);
+        ASSERT(obj);
+        ASSERT(!(((unsigned long) obj) & (sizeof(void *) - 1)));
+        ASSERT(*obj == 0xC0FFEE);
+        ASSERT(OBJ_CACHE(obj) == test_cache);
+        objects[i] = obj;
+        obj[0] = i;
+        obj[(TEST_OBJSIZE / sizeof(*obj)) - 1] = i;
+    }
+    ASSERT(constructed == test_cache->capacity);
+    for(unsigned long i = 0; i < TEST_OBJECTS; i++) {
+        obj = objects[i];
+        ASSERT(obj[0] == i);
+        ASSERT(obj[(TEST_OBJSIZE / sizeof(*obj)) - 1] == i);
+    }
+    for(unsigned long i = 0; i < TEST_OBJECTS; i++) {
+        obj = objects[i];
+        *obj = 0xC0FFEE;
+        cake_free(obj);
+    }
+    ASSERT(cache_free_objects(test_cache) == test_cache->capacity);
+    host_pass("slab objects");
+}
+
+static void slab_cpu(unsigned long cpu, void *arg)
+{
+    unsigned long *held[CPU_OBJECTS];
+    for(unsigned long round = 0; round < CPU_ROUNDS; round++) {
+        for(unsigned long i = 0; i < CPU_OBJECTS; i++) {
+            held[i] = alloc_obj(test_cache);
+            ASSERT(held[i]);
+            held[i][0] = (cpu << 32) | i;
+        }
+        for(unsigned long i = 0; i < CPU_OBJECTS; i++) {
+            ASSERT(held[i][0] == ((cpu << 32) | i));
+            cake_free(held[i]);
+        }
+    }
+}
+
+static void test_slab_cpus()
+{
+    host_run_cpus(slab_cpu, 0);
+    ASSERT(cache_free_objects(test_cache) == test_cache->capacity);
+    host_pass("slab cpus");
+}
+
+int main()
+{
+    host_init();
+    test_cake_alloc();
+    test_cake_alloc_index();
+    test_slab_objects();
+    test_slab_cpus();
+    test_slab_shrink();
+    return 0;
+}